@@ -0,0 +1,173 @@
+#include "Batch.h"
+
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "cache.h"
+
+using namespace std;
+
+uint64_t fileSize(const std::string& fileName) {
+    struct stat st;
+    return stat(fileName.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+bool makeDir(const std::string& dir) {
+    return mkdir(dir.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+bool readManifest(std::istream& manifest, const std::string& fileName,
+                  std::vector<BatchJob>& jobs) {
+    std::string line;
+    for (uint32_t lineNum = 1; getline(manifest, line); lineNum++) {
+        std::istringstream tokens(line);
+        std::vector<std::string> args;
+        for (std::string token; tokens >> token;) args.push_back(token);
+        if (args.empty() || args[0][0] == '#') continue;
+        if (args.size() < 2) {
+            cerr << LOG_ERROR << fileName << ":" << lineNum << ": missing cache config" << endl;
+            return false;
+        }
+
+        BatchJob job;
+        job.index = jobs.size();
+        // Jobs don't pick up a print_mem_range from wherever sim_batch was started
+        job.options.memRangeFile.clear();
+        job.binary = args[0];
+        job.cacheConfig = args[1];
+        for (size_t i = 2; i < args.size(); i++) {
+            job.optionText += (i > 2 ? " " : "") + args[i];
+        }
+        for (size_t i = 2; i < args.size(); i++) {
+            if (args[i] == "--init-image" && i + 1 < args.size()) {
+                job.initImage = args[++i];
+            } else if (!parseSimOption(args, i, job.options)) {
+                cerr << LOG_ERROR << fileName << ":" << lineNum << ": invalid options" << endl;
+                return false;
+            }
+        }
+        job.cost = (fileSize(job.binary) + fileSize(job.initImage)) * job.options.cores;
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+std::shared_ptr<const MemoryStore> ImageCache::get(const std::string& binary,
+                                                   const std::string& initImage) {
+    auto key = std::make_pair(binary, initImage);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = images.find(key);
+        if (found != images.end()) return found->second;
+    }
+
+    // Loaded without the lock so other images load meanwhile. If two jobs race to load the
+    // same image, the first one inserted is kept.
+    std::shared_ptr<const MemoryStore> image(new MemoryStore(
+        0, MEMORY_SIZE, binary.c_str(), initImage.empty() ? nullptr : initImage.c_str()));
+    std::lock_guard<std::mutex> lock(mutex);
+    return images.insert(std::make_pair(key, image)).first->second;
+}
+
+BatchResult runJob(const BatchJob& job, ImageCache& imageCache, const std::string& outDir) {
+    BatchResult result{ERROR, std::vector<SimulationStats>(job.options.cores), 0,
+                       outDir + "/job" + std::to_string(job.index)};
+    auto start = std::chrono::steady_clock::now();
+
+    if (!ifstream(job.binary) || (!job.initImage.empty() && !ifstream(job.initImage))) {
+        cerr << LOG_ERROR << "Job " << job.index << ": unable to open its inputs" << endl;
+        return result;
+    }
+    if (!makeDir(result.dir)) {
+        cerr << LOG_ERROR << "Unable to create " << result.dir << endl;
+        return result;
+    }
+
+    try {
+        CacheConfig icConfig, dcConfig;
+        readCacheConfigs(job.cacheConfig, icConfig, dcConfig);
+
+        std::string base = job.binary.substr(job.binary.rfind('/') + 1);
+        std::string output = result.dir + "/" + getBaseFilename(base.c_str()) + "_cycle";
+        CycleSimulator simulator;
+        MemoryStore* memory = new MemoryStore(*imageCache.get(job.binary, job.initImage));
+        if (simulator.init(icConfig, dcConfig, memory, output, job.options) == SUCCESS) {
+            result.status = simulator.runTillHalt();
+            simulator.finalize();
+            for (uint32_t core = 0; core < job.options.cores; core++) {
+                result.stats[core] = simulator.getStats(core);
+            }
+        }
+    } catch (const std::exception& e) {
+        cerr << LOG_ERROR << "Job " << job.index << ": " << e.what() << endl;
+        result.status = ERROR;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.seconds = elapsed.count();
+    return result;
+}
+
+const char BATCH_CSV_HEADER[] =
+    "job,core,binary,config,options,status,instructions,cycles,ic_hits,ic_misses,dc_hits,"
+    "dc_misses,load_stalls,seconds,dir\n";
+
+static std::string csvField(const std::string& value) {
+    if (value.find_first_of(",\"\n") == std::string::npos) return value;
+    std::string quoted = "\"";
+    for (char c : value) {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+static std::string jsonString(const std::string& value) {
+    std::string quoted = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') quoted += '\\';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+static const char* statusName(Status status) {
+    return status == HALT ? "halt" : status == SUCCESS ? "running" : "error";
+}
+
+std::string formatResult(const BatchJob& job, const BatchResult& result, bool jsonl) {
+    char seconds[32];
+    snprintf(seconds, sizeof(seconds), "%.3f", result.seconds);
+
+    std::ostringstream row;
+    for (size_t core = 0; core < result.stats.size(); core++) {
+        const SimulationStats& stats = result.stats[core];
+        if (jsonl) {
+            row << "{\"job\":" << job.index << ",\"core\":" << core
+                << ",\"binary\":" << jsonString(job.binary)
+                << ",\"config\":" << jsonString(job.cacheConfig)
+                << ",\"options\":" << jsonString(job.optionText)
+                << ",\"status\":\"" << statusName(result.status) << "\""
+                << ",\"instructions\":" << stats.dynamicInstructions
+                << ",\"cycles\":" << stats.totalCycles << ",\"ic_hits\":" << stats.icHits
+                << ",\"ic_misses\":" << stats.icMisses << ",\"dc_hits\":" << stats.dcHits
+                << ",\"dc_misses\":" << stats.dcMisses << ",\"load_stalls\":" << stats.loadStalls
+                << ",\"seconds\":" << seconds << ",\"dir\":" << jsonString(result.dir) << "}\n";
+        } else {
+            row << job.index << "," << core << "," << csvField(job.binary) << ","
+                << csvField(job.cacheConfig) << "," << csvField(job.optionText) << ","
+                << statusName(result.status) << "," << stats.dynamicInstructions << ","
+                << stats.totalCycles << "," << stats.icHits << "," << stats.icMisses << ","
+                << stats.dcHits << "," << stats.dcMisses << "," << stats.loadStalls << ","
+                << seconds << "," << csvField(result.dir) << "\n";
+        }
+    }
+    return row.str();
+}
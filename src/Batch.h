@@ -0,0 +1,65 @@
+#pragma once
+#include <inttypes.h>
+
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "MemoryStore.h"
+#include "Utilities.h"
+#include "cycle.h"
+
+// One line of a sim_batch manifest: `<file.bin> <cache_config.txt> [options]`, where the
+// options are those of sim_cycle plus `--init-image <file>`. Memory is dumped over the
+// default range unless the job gives --mem-range.
+struct BatchJob {
+    size_t index;
+    std::string binary;
+    std::string cacheConfig;
+    std::string initImage;  // empty for none
+    std::string optionText;
+    SimOptions options;
+    uint64_t cost;  // estimated from the input sizes, used to start the largest jobs first
+};
+
+struct BatchResult {
+    Status status;
+    std::vector<SimulationStats> stats;  // one per core
+    double seconds;
+    std::string dir;
+};
+
+// Size of a file, 0 if it does not exist
+uint64_t fileSize(const std::string& fileName);
+// Creates dir unless it exists
+bool makeDir(const std::string& dir);
+
+// Reads the jobs of a manifest, named fileName in the error messages. Blank lines and lines
+// starting with '#' are skipped. Returns false on the first invalid line.
+bool readManifest(std::istream& manifest, const std::string& fileName,
+                  std::vector<BatchJob>& jobs);
+
+// Loaded program images, shared by every job running the same binary and init image. Jobs
+// run on a private copy.
+class ImageCache {
+   private:
+    std::mutex mutex;
+    std::map<std::pair<std::string, std::string>, std::shared_ptr<const MemoryStore>> images;
+
+   public:
+    // Throws std::invalid_argument if the binary or the init image does not load
+    std::shared_ptr<const MemoryStore> get(const std::string& binary,
+                                           const std::string& initImage);
+};
+
+// Runs a job to completion with its own CycleSimulator, writing the outputs to
+// <outDir>/job<index>. A job that cannot start reports ERROR.
+BatchResult runJob(const BatchJob& job, ImageCache& imageCache, const std::string& outDir);
+
+extern const char BATCH_CSV_HEADER[];
+
+// Formats the result rows of a job, one per core, in the order of BATCH_CSV_HEADER
+std::string formatResult(const BatchJob& job, const BatchResult& result, bool jsonl);
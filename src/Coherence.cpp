@@ -0,0 +1,223 @@
+#include "Coherence.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+CoherentCache::CoherentCache(const CacheConfig& configParam, CoherenceBus* busParam)
+    : CacheModel(configParam), bus(busParam), useCount(0), penalty(0), deferred(false),
+      cycle(0), storeDrain(false), viewUseCount(0), corrections{0, 0} {
+    numSets = config.cacheSize / (config.blockSize * config.ways);
+    numWays = config.ways;
+    // Same index and tag split as the generic Cache
+    numOffsetBits = (uint32_t)(std::log2(config.blockSize / 4)) + 2;
+    indexMask = (1u << (uint32_t)(std::log2(numSets))) - 1;
+    lines.resize(numSets * numWays, Line{0, 0, LINE_INVALID});
+}
+
+CoherentCache::Line* CoherentCache::find(std::vector<Line>& from, uint32_t block) {
+    Line* set = &from[setOf(block) * numWays];
+    for (uint32_t way = 0; way < numWays; way++) {
+        if (set[way].state != LINE_INVALID && set[way].block == block) return &set[way];
+    }
+    return nullptr;
+}
+
+// an invalid line if the set has one, otherwise the least recently used
+CoherentCache::Line& CoherentCache::victim(std::vector<Line>& from, uint32_t block) {
+    Line* set = &from[setOf(block) * numWays];
+    Line* lru = &set[0];
+    for (uint32_t way = 0; way < numWays; way++) {
+        if (set[way].state == LINE_INVALID) return set[way];
+        if (set[way].lastUse < lru->lastUse) lru = &set[way];
+    }
+    return *lru;
+}
+
+bool CoherentCache::request(uint32_t block, bool exclusive) {
+    uint32_t invalidated = 0;
+    bool intervention = false;
+    bool shared = bus->request(this, block, exclusive, invalidated, intervention);
+    charge(invalidated, intervention);
+    return shared;
+}
+
+void CoherentCache::charge(uint32_t invalidated, bool intervention) {
+    stats.invalidationsSent += invalidated;
+    stats.interventions += intervention;
+    if (invalidated) penalty += COHERENCE_INVALIDATE_LATENCY;
+    if (intervention) penalty += COHERENCE_INTERVENTION_LATENCY;
+}
+
+bool CoherentCache::access(uint32_t address, CacheOperation readWrite) {
+    return deferred ? post(address, readWrite) : update(address, readWrite);
+}
+
+bool CoherentCache::update(uint32_t address, CacheOperation readWrite) {
+    uint32_t block = address >> numOffsetBits;
+    penalty = 0;
+
+    Line* line = find(lines, block);
+    bool hit = line != nullptr;
+    if (deferred) changedSets.push_back(setOf(block));
+    if (hit) {
+        if (readWrite == CACHE_WRITE && line->state == LINE_SHARED) {
+            // Write hit on a shared copy: invalidate the others before writing
+            request(block, true);
+            stats.upgrades++;
+        }
+        if (readWrite == CACHE_WRITE) line->state = LINE_MODIFIED;
+    } else {
+        if (invalidatedBlocks.erase(block)) stats.coherenceMisses++;
+        bool shared = request(block, readWrite == CACHE_WRITE);
+        line = &victim(lines, block);
+        if (setStats && line->state != LINE_INVALID) {
+            recordEviction(line->block << numOffsetBits);
+        }
+        line->block = block;
+        if (readWrite == CACHE_WRITE) {
+            line->state = LINE_MODIFIED;
+        } else {
+            bool exclusive = bus->getProtocol() == PROTOCOL_MESI && !shared;
+            line->state = exclusive ? LINE_EXCLUSIVE : LINE_SHARED;
+        }
+    }
+    line->lastUse = ++useCount;
+
+    record(address, hit);
+    return hit;
+}
+
+// Only hit or miss matters in the view, the states and the counters are left to the replay
+bool CoherentCache::post(uint32_t address, CacheOperation readWrite) {
+    uint32_t block = address >> numOffsetBits;
+    penalty = 0;
+
+    Line* line = find(view, block);
+    bool hit = line != nullptr;
+    changedSets.push_back(setOf(block));
+    if (!hit) {
+        line = &victim(view, block);
+        line->block = block;
+        line->state = LINE_SHARED;
+    }
+    line->lastUse = ++viewUseCount;
+
+    mailbox.push_back(PostedAccess{cycle, address, readWrite == CACHE_WRITE, storeDrain, hit});
+    return hit;
+}
+
+uint32_t CoherentCache::accessMany(const uint32_t* addresses, size_t count) {
+    uint32_t before = hits;
+    for (size_t i = 0; i < count; i++) access(addresses[i], CACHE_READ);
+    return hits - before;
+}
+
+LineState CoherentCache::snoop(uint32_t block, bool exclusive) {
+    Line* line = find(lines, block);
+    if (!line) return LINE_INVALID;
+    LineState previous = line->state;
+    if (deferred) changedSets.push_back(setOf(block));
+    if (exclusive) {
+        line->state = LINE_INVALID;
+        invalidatedBlocks.insert(block);
+        stats.invalidationsReceived++;
+    } else {
+        line->state = LINE_SHARED;
+    }
+    return previous;
+}
+
+void CoherentCache::setDeferred(bool deferredParam) {
+    deferred = deferredParam;
+    view = lines;
+    viewUseCount = useCount;
+    changedSets.clear();
+}
+
+void CoherentCache::replay(const PostedAccess& posted) {
+    bool hit = update(posted.address, posted.write ? CACHE_WRITE : CACHE_READ);
+    int32_t& correction = corrections[posted.storeDrain];
+    correction += penalty;
+    if (hit != posted.hit) correction += hit ? -(int32_t)config.missLatency : config.missLatency;
+}
+
+void CoherentCache::endQuantum() {
+    for (uint32_t set : changedSets) {
+        std::copy_n(&lines[set * numWays], numWays, &view[set * numWays]);
+    }
+    changedSets.clear();
+    viewUseCount = useCount;
+}
+
+int32_t CoherentCache::takeCorrection(bool storeDrainParam) {
+    int32_t taken = corrections[storeDrainParam];
+    corrections[storeDrainParam] = 0;
+    return taken;
+}
+
+LineState CoherentCache::getState(uint32_t address) {
+    Line* line = find(lines, address >> numOffsetBits);
+    return line ? line->state : LINE_INVALID;
+}
+
+bool CoherenceBus::request(CoherentCache* requester, uint32_t block, bool exclusive,
+                           uint32_t& invalidated, bool& intervention) {
+    bool shared = false;
+    for (CoherentCache* cache : caches) {
+        if (cache == requester) continue;
+        LineState previous = cache->snoop(block, exclusive);
+        shared = shared || previous != LINE_INVALID;
+        invalidated += exclusive && previous != LINE_INVALID;
+        intervention = intervention || previous == LINE_MODIFIED;
+    }
+    return shared;
+}
+
+void CoherenceBus::drain() {
+    struct Posted {
+        PostedAccess access;
+        CoherentCache* cache;
+    };
+    std::vector<Posted> posted;
+    for (CoherentCache* cache : caches) {
+        for (const PostedAccess& access : cache->getMailbox()) {
+            posted.push_back(Posted{access, cache});
+        }
+        cache->getMailbox().clear();
+    }
+    // Ties go to the lower core, as in a lockstep run
+    std::stable_sort(posted.begin(), posted.end(), [](const Posted& lhs, const Posted& rhs) {
+        return lhs.access.cycle < rhs.access.cycle;
+    });
+
+    for (const Posted& entry : posted) entry.cache->replay(entry.access);
+    for (CoherentCache* cache : caches) cache->endQuantum();
+}
+
+Status CoherenceBus::dump(const std::string& base_output_name) {
+    ofstream out(base_output_name + "_coherence.out");
+    if (!out) {
+        cerr << LOG_ERROR << "Could not open coherence stats file!" << endl;
+        return ERROR;
+    }
+
+    out << "Protocol: " << (protocol == PROTOCOL_MESI ? "MESI" : "MSI") << endl;
+    char line[160];
+    snprintf(line, sizeof(line), "%-6s %10s %10s %10s %12s %12s %10s %10s\n", "Core", "Hits",
+             "Misses", "Coherence", "Inval sent", "Inval recv", "Upgrades", "Interv");
+    out << line;
+    for (size_t core = 0; core < caches.size(); core++) {
+        CoherenceStats stats = caches[core]->getStats();
+        snprintf(line, sizeof(line), "%-6zu %10u %10u %10u %12u %12u %10u %10u\n", core,
+                 caches[core]->getHits(), caches[core]->getMisses(), stats.coherenceMisses,
+                 stats.invalidationsSent, stats.invalidationsReceived, stats.upgrades,
+                 stats.interventions);
+        out << line;
+    }
+    return SUCCESS;
+}
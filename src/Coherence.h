@@ -0,0 +1,150 @@
+#pragma once
+#include <inttypes.h>
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "Utilities.h"
+#include "cache.h"
+
+// Snooping protocol kept between the private data caches of a multi-core run. MESI adds an
+// Exclusive state so a block nobody else holds can be written without a bus transaction.
+enum CoherenceProtocol { PROTOCOL_MSI, PROTOCOL_MESI };
+
+enum LineState { LINE_INVALID, LINE_SHARED, LINE_EXCLUSIVE, LINE_MODIFIED };
+
+// Extra cycles charged to the requester when its request invalidates copies in other caches,
+// and when another cache has to supply a modified block.
+static const uint32_t COHERENCE_INVALIDATE_LATENCY = 4;
+static const uint32_t COHERENCE_INTERVENTION_LATENCY = 8;
+
+struct CoherenceStats {
+    uint32_t coherenceMisses = 0;        // misses on blocks another core invalidated
+    uint32_t upgrades = 0;               // writes that hit a Shared block
+    uint32_t invalidationsSent = 0;      // copies invalidated in other caches
+    uint32_t invalidationsReceived = 0;  // own copies invalidated by other caches
+    uint32_t interventions = 0;          // misses served from a Modified copy elsewhere
+};
+
+// A D-cache access made by a core during a parallel quantum, replayed at the next drain()
+struct PostedAccess {
+    uint32_t cycle;
+    uint32_t address;
+    bool write;
+    bool storeDrain;  // made by a store draining from a store buffer, not by the MEM stage
+    bool hit;         // as seen by the core's own copy of its cache during the quantum
+};
+
+class CoherenceBus;
+
+// Private data cache of one core. Same geometry and LRU replacement as the generic Cache,
+// plus a protocol state per line. Every access goes through the bus on a miss or upgrade.
+//
+// Parallel runs defer the bus: during a quantum a core looks its accesses up in a copy of its
+// cache and posts them to a mailbox. The bus replays every mailbox at the barrier in the order
+// of a lockstep run, and the difference to what the core assumed is handed to the pipeline.
+class CoherentCache : public CacheModel {
+   private:
+    struct Line {
+        uint32_t block;  // address >> offset bits
+        uint32_t lastUse;
+        LineState state;
+    };
+
+    CoherenceBus* bus;
+    uint32_t numSets;
+    uint32_t numWays;
+    uint32_t numOffsetBits;
+    uint32_t indexMask;
+    uint32_t useCount;
+    std::vector<Line> lines;
+    // Blocks invalidated by another core and not fetched since
+    std::unordered_set<uint32_t> invalidatedBlocks;
+    uint32_t penalty;
+    CoherenceStats stats;
+
+    // Parallel runs: the copy the core sees during a quantum, its accesses since the last
+    // barrier, and the cycles the replayed accesses of the MEM stage and of store drains took
+    // beyond what the core assumed
+    bool deferred;
+    uint32_t cycle;
+    bool storeDrain;
+    std::vector<Line> view;
+    uint32_t viewUseCount;
+    std::vector<uint32_t> changedSets;  // sets of lines or view changed during the quantum
+    std::vector<PostedAccess> mailbox;
+    int32_t corrections[2];
+
+    uint32_t setOf(uint32_t block) { return block & indexMask; }
+    Line* find(std::vector<Line>& from, uint32_t block);
+    Line& victim(std::vector<Line>& from, uint32_t block);
+    // Sends a request. Returns whether another cache had the block.
+    bool request(uint32_t block, bool exclusive);
+    void charge(uint32_t invalidated, bool intervention);
+    // An access that goes through the bus right away
+    bool update(uint32_t address, CacheOperation readWrite);
+    // An access looked up in the copy of a deferred cache
+    bool post(uint32_t address, CacheOperation readWrite);
+
+   public:
+    CoherentCache(const CacheConfig& configParam, CoherenceBus* busParam);
+
+    bool access(uint32_t address, CacheOperation readWrite) override;
+    uint32_t accessMany(const uint32_t* addresses, size_t count) override;
+
+    // Called by the bus for another core's request. Returns the state the block was in.
+    LineState snoop(uint32_t block, bool exclusive);
+    // State of the block holding address, LINE_INVALID if not cached
+    LineState getState(uint32_t address);
+
+    // Post accesses to the mailbox instead of sending bus requests right away
+    void setDeferred(bool deferredParam);
+    // Cycle of the core, used to order posted accesses, and whether the next accesses drain a
+    // store buffer
+    void setCycle(uint32_t cycleParam, bool storeDrainParam = false) {
+        cycle = cycleParam;
+        storeDrain = storeDrainParam;
+    }
+    std::vector<PostedAccess>& getMailbox() { return mailbox; }
+    // Called by the bus to replay a posted access
+    void replay(const PostedAccess& posted);
+    // Called by the bus once every mailbox was replayed, to start the next quantum from the
+    // replayed state
+    void endQuantum();
+    // Cycles the replayed accesses of the MEM stage or of store drains took beyond what the
+    // core assumed since the last call, negative if fewer
+    int32_t takeCorrection(bool storeDrainParam);
+
+    // Coherence cycles charged to the last access, on top of any miss latency
+    uint32_t getPenalty() { return penalty; }
+    CoherenceStats getStats() { return stats; }
+    uint32_t getOffsetBits() { return numOffsetBits; }
+};
+
+// Broadcast bus connecting the private data caches. Requests are snooped by every other cache
+// in attach order and complete atomically.
+class CoherenceBus {
+   private:
+    CoherenceProtocol protocol;
+    std::vector<CoherentCache*> caches;
+
+   public:
+    explicit CoherenceBus(CoherenceProtocol protocolParam) : protocol(protocolParam) {}
+
+    void attach(CoherentCache* cache) { caches.push_back(cache); }
+    CoherenceProtocol getProtocol() { return protocol; }
+
+    // Snoops every cache but requester. A read downgrades other copies to Shared, an exclusive
+    // request (write miss or upgrade) invalidates them. Returns whether another copy existed,
+    // and counts the invalidated and Modified copies.
+    bool request(CoherentCache* requester, uint32_t block, bool exclusive,
+                 uint32_t& invalidated, bool& intervention);
+
+    // Replays the accesses posted by every cache, ordered by cycle and then by core as in a
+    // lockstep run. Only call while no core is running.
+    void drain();
+
+    // Writes the coherence counters of every cache to <base>_coherence.out
+    Status dump(const std::string& base_output_name);
+};
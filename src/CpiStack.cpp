@@ -0,0 +1,75 @@
+#include "CpiStack.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+static const char* const causeNames[NUM_STALL_CAUSES] = {
+    "Base", "I-cache miss", "D-cache miss", "Load-use", "Load-branch", "Arith-branch",
+    "Mul/div busy", "Exception squash", "Fill/halt drain",
+};
+
+uint64_t CpiStack::getPCCycles(uint32_t pc, StallCause cause) {
+    auto it = perPC.find(pc);
+    return it == perPC.end() ? 0 : it->second.cycles[cause];
+}
+
+Status CpiStack::dump(const std::string& base_output_name, uint32_t instructions) {
+    ofstream out(base_output_name + "_cpi_stack.out");
+    if (!out) {
+        cerr << LOG_ERROR << "Could not open CPI stack file!" << endl;
+        return ERROR;
+    }
+
+    uint64_t total = 0;
+    for (uint64_t count : cycles) total += count;
+    double perInstr = instructions ? 1.0 / instructions : 0.0;
+
+    char line[160];
+    snprintf(line, sizeof(line), "%-18s %12s %8s %8s\n", "Cause", "Cycles", "CPI", "Share");
+    out << line;
+    for (int cause = 0; cause < NUM_STALL_CAUSES; cause++) {
+        snprintf(line, sizeof(line), "%-18s %12" PRIu64 " %8.3f %7.2f%%\n", causeNames[cause],
+                 cycles[cause], cycles[cause] * perInstr,
+                 total ? 100.0 * cycles[cause] / total : 0.0);
+        out << line;
+    }
+    snprintf(line, sizeof(line), "%-18s %12" PRIu64 " %8.3f\n", "Total", total,
+             total * perInstr);
+    out << line << endl;
+
+    // Rank the static PCs by the stall cycles charged to them
+    vector<pair<uint64_t, uint32_t>> ranked;
+    ranked.reserve(perPC.size());
+    for (auto& entry : perPC) {
+        uint64_t stalls = 0;
+        for (uint64_t count : entry.second.cycles) stalls += count;
+        ranked.emplace_back(stalls, entry.first);
+    }
+    sort(ranked.begin(), ranked.end(), [](const pair<uint64_t, uint32_t>& lhs,
+                                          const pair<uint64_t, uint32_t>& rhs) {
+        return lhs.first != rhs.first ? lhs.first > rhs.first : lhs.second < rhs.second;
+    });
+
+    out << "Stall cycles by PC" << endl;
+    snprintf(line, sizeof(line), "%-10s  %-24s %8s %8s %8s %8s %8s %8s %8s %8s\n", "PC",
+             "Instruction", "Total", "I-miss", "D-miss", "Ld-use", "Ld-br", "Ar-br", "Mul-div",
+             "Except");
+    out << line;
+    for (auto& entry : ranked) {
+        PCStalls& stalls = perPC[entry.second];
+        snprintf(line, sizeof(line), "0x%08x %s %8" PRIu64, entry.second,
+                 getInstrColumn(stalls.instruction).c_str(), entry.first);
+        out << line;
+        for (int cause = STALL_I_MISS; cause <= STALL_EXCEPTION; cause++) {
+            snprintf(line, sizeof(line), " %8" PRIu64, stalls.cycles[cause]);
+            out << line;
+        }
+        out << '\n';
+    }
+    return SUCCESS;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <inttypes.h>
+
+#include <string>
+#include <unordered_map>
+
+#include "Utilities.h"
+
+// Why a cycle did not retire an instruction. Cycles are attributed when they reach WB: every
+// bubble carries the cause and PC of the stall or squash that created it.
+enum StallCause {
+    STALL_NONE,          // an instruction retired
+    STALL_I_MISS,        // IF waiting on the I-cache
+    STALL_D_MISS,        // MEM waiting on the D-cache
+    STALL_LOAD_USE,      // ID waiting on a load result
+    STALL_LOAD_BRANCH,   // branch in ID waiting on a load result
+    STALL_ARITH_BRANCH,  // branch in ID waiting on an ALU result
+    STALL_MUL_DIV,       // mult/div in ID waiting for the unit, mfhi/mflo for its result
+    STALL_EXCEPTION,     // squashed by an overflow or illegal instruction
+    STALL_HALT_DRAIN,    // pipeline fill at start-up and drain behind the halt
+    NUM_STALL_CAUSES
+};
+
+// Cycle counts by cause, both for the whole run and per static PC.
+class CpiStack {
+   private:
+    struct PCStalls {
+        uint32_t instruction = 0;
+        uint64_t cycles[NUM_STALL_CAUSES] = {};
+    };
+
+    uint64_t cycles[NUM_STALL_CAUSES] = {};
+    std::unordered_map<uint32_t, PCStalls> perPC;
+
+   public:
+    // Counts one cycle. pc and instruction belong to the instruction the stall is charged to.
+    void charge(StallCause cause, uint32_t pc, uint32_t instruction) {
+        cycles[cause]++;
+        if (cause == STALL_NONE || cause == STALL_HALT_DRAIN) return;
+        PCStalls& stalls = perPC[pc];
+        stalls.instruction = instruction;
+        stalls.cycles[cause]++;
+    }
+
+    uint64_t getCycles(StallCause cause) { return cycles[cause]; }
+    uint64_t getPCCycles(uint32_t pc, StallCause cause);
+
+    // Writes the CPI stack and the PCs ranked by stall cycles to <base>_cpi_stack.out
+    Status dump(const std::string& base_output_name, uint32_t instructions);
+};
@@ -0,0 +1,91 @@
+#include "Dram.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+DramConfig readDramConfig(const std::string& configFile) {
+    std::ifstream file(configFile);
+    if (!file.is_open()) {
+        throw std::invalid_argument("Failed to open DRAM config file: " + configFile);
+    }
+
+    int line = 0;
+    auto parseNextLine = [&](const char* name) -> uint32_t {
+        line++;
+        uint32_t value;
+        if (!(file >> value)) {
+            std::stringstream errorMessage;
+            errorMessage << "Failed to parse property at line " << line << " for property "
+                         << name;
+            throw std::invalid_argument(errorMessage.str());
+        }
+        std::string discard;
+        std::getline(file, discard);  // discard rest of the line
+        return value;
+    };
+
+    DramConfig config;
+    config.banks = parseNextLine("DRAM banks");
+    config.rowBytes = parseNextLine("DRAM row size");
+    config.tCAS = parseNextLine("DRAM tCAS");
+    config.tRCD = parseNextLine("DRAM tRCD");
+    config.tRP = parseNextLine("DRAM tRP");
+    config.tBurst = parseNextLine("DRAM tBurst");
+    if (config.banks == 0 || config.rowBytes == 0) {
+        throw std::invalid_argument("DRAM banks and row size must be positive");
+    }
+    return config;
+}
+
+Dram::Dram(const DramConfig& configParam)
+    : config(configParam), banks(configParam.banks), busFreeAt(0) {}
+
+bool Dram::isRowHit(const Request& request) {
+    const Bank& bank = banks[getBank(request.address)];
+    return bank.open && bank.row == getRow(request.address);
+}
+
+void Dram::enqueue(DramSource source, uint32_t address, uint64_t cycle) {
+    queue.push_back(Request{source, address, cycle});
+}
+
+void Dram::issue(uint32_t latencies[DRAM_SOURCES]) {
+    while (!queue.empty()) {
+        // First ready: the oldest row hit, else the oldest request
+        auto next = std::find_if(queue.begin(), queue.end(),
+                                 [this](const Request& request) { return isRowHit(request); });
+        if (next == queue.end()) next = queue.begin();
+        Request request = *next;
+        queue.erase(next);
+
+        Bank& bank = banks[getBank(request.address)];
+        uint32_t row = getRow(request.address);
+        uint64_t start = std::max(request.arrival, bank.readyAt);
+        uint32_t access = config.tCAS;
+        if (!bank.open) {
+            access += config.tRCD;
+            stats.rowMisses++;
+        } else if (bank.row != row) {
+            access += config.tRP + config.tRCD;
+            stats.rowConflicts++;
+        } else {
+            stats.rowHits++;
+        }
+        bank.open = true;
+        bank.row = row;
+        bank.readyAt = start + access;
+
+        // The data bus is shared by all banks
+        uint64_t done = std::max(start + access, busFreeAt) + config.tBurst;
+        busFreeAt = done;
+
+        uint32_t latency = done - request.arrival;
+        latencies[request.source] = latency;
+        stats.requests++;
+        stats.totalLatency += latency;
+    }
+}
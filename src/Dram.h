@@ -0,0 +1,73 @@
+#pragma once
+#include <inttypes.h>
+
+#include <string>
+#include <vector>
+
+// Sources of DRAM requests within one core. The pipeline blocks on a miss, so each has at
+// most one request in flight.
+enum DramSource { DRAM_IFETCH, DRAM_DATA, DRAM_SOURCES };
+
+// DRAM channel geometry and timing, in cycles. Addresses map to row : bank : column, so
+// consecutive rows of rowBytes go to consecutive banks.
+struct DramConfig {
+    uint32_t banks = 8;
+    uint32_t rowBytes = 2048;
+    uint32_t tCAS = 11;   // column access to data
+    uint32_t tRCD = 11;   // row activate to column access
+    uint32_t tRP = 11;    // precharge (closing the open row)
+    uint32_t tBurst = 4;  // data bus cycles per block
+};
+
+// Reads a DRAM config (banks, row bytes, tCAS, tRCD, tRP, tBurst; one value per line, like
+// the cache config). Throws std::invalid_argument if it can't be parsed or is invalid.
+DramConfig readDramConfig(const std::string& configFile);
+
+struct DramStats {
+    uint64_t requests = 0;
+    uint64_t rowHits = 0;       // the row was already open
+    uint64_t rowMisses = 0;     // the bank had no open row
+    uint64_t rowConflicts = 0;  // another row had to be closed first
+    uint64_t totalLatency = 0;  // cycles from arrival to the end of the data burst
+};
+
+// Open-page DRAM channel with per-bank row buffers, a shared data bus and an FR-FCFS
+// scheduler: requests that hit an open row go first, otherwise the oldest.
+class Dram {
+   private:
+    struct Bank {
+        bool open = false;
+        uint32_t row = 0;
+        uint64_t readyAt = 0;  // next cycle the bank accepts a command
+    };
+    struct Request {
+        DramSource source;
+        uint32_t address;
+        uint64_t arrival;
+    };
+
+    DramConfig config;
+    std::vector<Bank> banks;
+    std::vector<Request> queue;
+    uint64_t busFreeAt;
+    DramStats stats;
+
+    uint32_t getBank(uint32_t address) { return (address / config.rowBytes) % config.banks; }
+    uint32_t getRow(uint32_t address) {
+        return address / config.rowBytes / config.banks;
+    }
+    bool isRowHit(const Request& request);
+
+   public:
+    explicit Dram(const DramConfig& configParam);
+
+    // Queues a cache miss that arrived at cycle
+    void enqueue(DramSource source, uint32_t address, uint64_t cycle);
+    bool hasPending() { return !queue.empty(); }
+    // Issues every queued request in FR-FCFS order and sets latencies[source] to the cycles
+    // until its data arrives, counted from its arrival. Sources without a request keep their
+    // value.
+    void issue(uint32_t latencies[DRAM_SOURCES]);
+
+    DramStats getStats() { return stats; }
+};
@@ -0,0 +1,151 @@
+#include "ExecProfile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include "emulator.h"
+
+using namespace std;
+
+// Branches and jumps get taken/not-taken counts, their delay slot ends the basic block
+static bool isControlInstr(uint32_t instruction) {
+    switch (instruction >> 26) {
+        case OP_BEQ:
+        case OP_BNE:
+        case OP_BLEZ:
+        case OP_BGTZ:
+        case OP_J:
+        case OP_JAL:
+            return true;
+        case OP_ZERO:
+            return (instruction & 0x3f) == FUN_JR;
+        default:
+            return false;
+    }
+}
+
+ExecProfile::ExecProfile() : prevPC(0) {}
+
+ExecProfile::PCCounts& ExecProfile::grow(uint32_t idx) {
+    if (idx >= MAX_DENSE_PCS) return sparseCounts[idx];
+    // Double so a program walking up through memory costs amortized O(1) per new PC
+    size_t size = max<size_t>(1024, counts.size());
+    while (size <= idx) size *= 2;
+    counts.resize(min<size_t>(size, MAX_DENSE_PCS));
+    return counts[idx];
+}
+
+const ExecProfile::PCCounts* ExecProfile::find(uint32_t idx) const {
+    if (idx < counts.size()) return &counts[idx];
+    auto it = sparseCounts.find(idx);
+    return it != sparseCounts.end() ? &it->second : nullptr;
+}
+
+uint64_t ExecProfile::getExecutions(uint32_t pc) {
+    const PCCounts* entry = find(pc >> 2);
+    return entry ? entry->executions : 0;
+}
+
+uint64_t ExecProfile::getTaken(uint32_t pc) {
+    const PCCounts* entry = find(pc >> 2);
+    return entry ? entry->taken : 0;
+}
+
+Status ExecProfile::dump(const std::string& base_output_name, MemoryStore* memory) {
+    ofstream out(base_output_name + "_profile.out");
+    if (!out) {
+        cerr << LOG_ERROR << "Could not open profile file!" << endl;
+        return ERROR;
+    }
+
+    struct PCEntry {
+        uint32_t pc;
+        uint32_t instruction;
+        uint64_t executions;
+    };
+    struct Block {
+        uint32_t start;
+        uint32_t length;
+        uint64_t executions;
+    };
+
+    // Executed PCs in address order: the dense array, then the spilled ones
+    vector<uint32_t> indices;
+    for (uint32_t idx = 0; idx < counts.size(); idx++) {
+        if (counts[idx].executions) indices.push_back(idx);
+    }
+    size_t denseCount = indices.size();
+    for (auto& entry : sparseCounts) indices.push_back(entry.first);
+    sort(indices.begin() + denseCount, indices.end());
+
+    vector<PCEntry> pcs;
+    vector<Block> blocks;
+    uint64_t total = 0;
+    bool prevEndsBlock = true;
+    bool prevIsControl = false;
+    for (size_t i = 0; i < indices.size(); i++) {
+        uint32_t idx = indices[i];
+        const PCCounts& entry = *find(idx);
+        // A gap of unexecuted PCs ends the block as well
+        if (i > 0 && idx != indices[i - 1] + 1) {
+            prevEndsBlock = true;
+            prevIsControl = false;
+        }
+        uint32_t pc = idx << 2;
+        uint32_t instruction = 0;
+        memory->getMemValue(pc, instruction, WORD_SIZE);
+        pcs.push_back(PCEntry{pc, instruction, entry.executions});
+        total += entry.executions;
+
+        // A block starts wherever control arrived from elsewhere or after a delay slot
+        if (prevEndsBlock || entry.entries) {
+            blocks.push_back(Block{pc, 0, entry.executions});
+        }
+        blocks.back().length++;
+        prevEndsBlock = prevIsControl;
+        prevIsControl = isControlInstr(instruction);
+    }
+
+    sort(blocks.begin(), blocks.end(), [](const Block& lhs, const Block& rhs) {
+        uint64_t lhsDyn = lhs.executions * lhs.length, rhsDyn = rhs.executions * rhs.length;
+        return lhsDyn != rhsDyn ? lhsDyn > rhsDyn : lhs.start < rhs.start;
+    });
+    stable_sort(pcs.begin(), pcs.end(), [](const PCEntry& lhs, const PCEntry& rhs) {
+        return lhs.executions > rhs.executions;
+    });
+
+    char line[160];
+    double toShare = total ? 100.0 / total : 0.0;
+    out << "Basic blocks by dynamic instructions" << endl;
+    snprintf(line, sizeof(line), "%-10s %-10s %8s %12s %14s %8s\n", "Start", "End", "Length",
+             "Executions", "Instructions", "Share");
+    out << line;
+    for (const Block& block : blocks) {
+        uint64_t dynamic = block.executions * block.length;
+        snprintf(line, sizeof(line), "0x%08x 0x%08x %8u %12" PRIu64 " %14" PRIu64 " %7.2f%%\n",
+                 block.start, block.start + 4 * (block.length - 1), block.length,
+                 block.executions, dynamic, dynamic * toShare);
+        out << line;
+    }
+
+    out << endl << "PCs by executions" << endl;
+    snprintf(line, sizeof(line), "%-10s  %-24s %12s %8s %12s %12s\n", "PC", "Instruction",
+             "Executions", "Share", "Taken", "Not taken");
+    out << line;
+    for (const PCEntry& entry : pcs) {
+        snprintf(line, sizeof(line), "0x%08x %s %12" PRIu64 " %7.2f%%", entry.pc,
+                 getInstrColumn(entry.instruction).c_str(), entry.executions,
+                 entry.executions * toShare);
+        out << line;
+        if (isControlInstr(entry.instruction)) {
+            uint64_t taken = find(entry.pc >> 2)->taken;
+            snprintf(line, sizeof(line), " %12" PRIu64 " %12" PRIu64, taken,
+                     entry.executions - taken);
+            out << line;
+        }
+        out << '\n';
+    }
+    return SUCCESS;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <inttypes.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MemoryStore.h"
+#include "Utilities.h"
+
+// Execution profile of a functional run: how often each static PC ran, how often control
+// arrived there non-sequentially and, for branches and jumps, how often they were taken.
+// Counters live in a dense array indexed by PC >> 2 that grows to the highest PC executed,
+// up to MAX_DENSE_PCS. PCs above that are counted in a hash map instead.
+class ExecProfile {
+   private:
+    struct PCCounts {
+        uint64_t executions = 0;
+        uint64_t entries = 0;  // times reached other than by falling through from PC - 4
+        uint64_t taken = 0;    // times the branch or jump redirected the PC
+    };
+
+    // 16 MB of code, so a jump to the top of memory can't allocate gigabytes
+    static const uint32_t MAX_DENSE_PCS = 1 << 22;
+
+    std::vector<PCCounts> counts;
+    std::unordered_map<uint32_t, PCCounts> sparseCounts;
+    uint32_t prevPC;
+
+    PCCounts& grow(uint32_t idx);
+    const PCCounts* find(uint32_t idx) const;
+
+   public:
+    ExecProfile();
+
+    // Counts one execution of the instruction at pc, taken is set if it is a branch or jump
+    // that redirected the PC. Called once per retired instruction.
+    void record(uint32_t pc, bool taken) {
+        uint32_t idx = pc >> 2;
+        PCCounts& entry = idx < counts.size() ? counts[idx] : grow(idx);
+        entry.executions++;
+        if (pc != prevPC + 4) entry.entries++;
+        if (taken) entry.taken++;
+        prevPC = pc;
+    }
+
+    uint64_t getExecutions(uint32_t pc);
+    uint64_t getTaken(uint32_t pc);
+
+    // Writes the basic blocks and PCs sorted by dynamic instruction count, with disassembly
+    // read back from memory, to <base>_profile.out
+    Status dump(const std::string& base_output_name, MemoryStore* memory);
+};
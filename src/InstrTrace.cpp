@@ -0,0 +1,207 @@
+#include "InstrTrace.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "Utilities.h"
+
+using namespace std;
+
+// zigzag maps small negative and positive deltas to small unsigned values
+static inline uint32_t zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+TraceWriter::TraceWriter()
+    : prevPC(0), prevMemAddr(0), cachedPC(TRACE_WORD_CACHE_SIZE, 1),
+      cachedWord(TRACE_WORD_CACHE_SIZE, 0) {}
+
+Status TraceWriter::open(const std::string &fileName) {
+    out.open(fileName, ios::binary | ios::out);
+    if (!out) {
+        cerr << LOG_ERROR << "Could not create trace file " << fileName << endl;
+        return ERROR;
+    }
+    buf.reserve(TRACE_BUFFER_SIZE + 32);
+    buf.insert(buf.end(), TRACE_MAGIC, TRACE_MAGIC + TRACE_MAGIC_LEN);
+    return SUCCESS;
+}
+
+void TraceWriter::putVarint(int32_t value) {
+    uint32_t bits = zigzag(value);
+    while (bits >= 0x80) {
+        buf.push_back((bits & 0x7f) | 0x80);
+        bits >>= 7;
+    }
+    buf.push_back(bits);
+}
+
+void TraceWriter::putWord(uint32_t value) {
+    buf.push_back(value >> 24);
+    buf.push_back(value >> 16);
+    buf.push_back(value >> 8);
+    buf.push_back(value);
+}
+
+void TraceWriter::flush() {
+    out.write(reinterpret_cast<const char *>(buf.data()), buf.size());
+    buf.clear();
+}
+
+void TraceWriter::write(const Emulator::InstructionInfo &info) {
+    uint32_t slot = (info.pc >> 2) & (TRACE_WORD_CACHE_SIZE - 1);
+    bool hasMem = traceHasMemAddress(info);
+    uint32_t memAddr = info.loadAddress | info.storeAddress;
+
+    uint8_t flags = 0;
+    if (info.pc == prevPC + 4) flags |= TRACE_SEQUENTIAL;
+    if (cachedPC[slot] == info.pc && cachedWord[slot] == info.instruction) {
+        flags |= TRACE_WORD_CACHED;
+    }
+    if (hasMem) flags |= TRACE_MEM;
+    if (info.isBranchTaken) flags |= TRACE_TAKEN;
+    if (info.isOverflow) flags |= TRACE_OVERFLOW;
+    if (!info.isValid) flags |= TRACE_INVALID;
+
+    buf.push_back(flags);
+    if (!(flags & TRACE_SEQUENTIAL)) putVarint(info.pc - (prevPC + 4));
+    if (!(flags & TRACE_WORD_CACHED)) putWord(info.instruction);
+    if (hasMem) {
+        putVarint(memAddr - prevMemAddr);
+        prevMemAddr = memAddr;
+    }
+
+    prevPC = info.pc;
+    cachedPC[slot] = info.pc;
+    cachedWord[slot] = info.instruction;
+
+    if (buf.size() >= TRACE_BUFFER_SIZE) flush();
+}
+
+void TraceWriter::close() {
+    if (out.is_open()) {
+        flush();
+        out.close();
+    }
+}
+
+TraceReader::TraceReader()
+    : pos(0), prevPC(0), prevMemAddr(0), records(0), count(0),
+      cachedPC(TRACE_WORD_CACHE_SIZE, 1), cachedWord(TRACE_WORD_CACHE_SIZE, 0),
+      hasPending(false) {}
+
+Status TraceReader::open(const std::string &fileName) {
+    in.open(fileName, ios::binary | ios::in);
+    if (!in) {
+        cerr << LOG_ERROR << "Could not open trace file " << fileName << endl;
+        return ERROR;
+    }
+    if (!fill(TRACE_MAGIC_LEN) ||
+        !equal(TRACE_MAGIC, TRACE_MAGIC + TRACE_MAGIC_LEN, buf.begin())) {
+        cerr << LOG_ERROR << "Not an instruction trace: " << fileName << endl;
+        return ERROR;
+    }
+    pos = TRACE_MAGIC_LEN;
+    hasPending = readRecord(pending);
+    return SUCCESS;
+}
+
+// Makes sure at least `needed` unread bytes are buffered, reading the next chunk if not.
+bool TraceReader::fill(size_t needed) {
+    if (buf.size() - pos >= needed) return true;
+    buf.erase(buf.begin(), buf.begin() + pos);
+    pos = 0;
+    size_t have = buf.size();
+    buf.resize(have + TRACE_BUFFER_SIZE);
+    in.read(reinterpret_cast<char *>(buf.data() + have), TRACE_BUFFER_SIZE);
+    buf.resize(have + in.gcount());
+    return buf.size() >= needed;
+}
+
+bool TraceReader::getByte(uint8_t &value) {
+    if (!fill(1)) return false;
+    value = buf[pos++];
+    return true;
+}
+
+bool TraceReader::getVarint(int32_t &value) {
+    uint32_t bits = 0;
+    uint8_t byte = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (!getByte(byte)) return false;
+        bits |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            value = unzigzag(bits);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TraceReader::readRecord(Emulator::InstructionInfo &info) {
+    uint8_t flags;
+    if (!getByte(flags)) return false;
+
+    info = Emulator::InstructionInfo();
+    int32_t delta = 0;
+    if (!(flags & TRACE_SEQUENTIAL) && !getVarint(delta)) return false;
+    info.pc = prevPC + 4 + delta;
+
+    uint32_t slot = (info.pc >> 2) & (TRACE_WORD_CACHE_SIZE - 1);
+    if (flags & TRACE_WORD_CACHED) {
+        info.instruction = cachedWord[slot];
+    } else {
+        if (!fill(4)) return false;
+        info.instruction = ((uint32_t)buf[pos] << 24) | (buf[pos + 1] << 16) |
+                           (buf[pos + 2] << 8) | buf[pos + 3];
+        pos += 4;
+    }
+
+    uint32_t memAddr = 0;
+    if (flags & TRACE_MEM) {
+        if (!getVarint(delta)) return false;
+        memAddr = prevMemAddr + delta;
+        prevMemAddr = memAddr;
+    }
+
+    prevPC = info.pc;
+    cachedPC[slot] = info.pc;
+    cachedWord[slot] = info.instruction;
+
+    info.instructionID = records++;
+    info.isHalt = (info.instruction == 0xfeedfeed);
+    info.isValid = !(flags & TRACE_INVALID);
+    info.isOverflow = flags & TRACE_OVERFLOW;
+    info.isBranchTaken = flags & TRACE_TAKEN;
+    info.nextPC = info.pc + 4;  // corrected once the following record is read
+    if (!info.isHalt) {
+        Emulator::decode(info.instruction, info.nextPC, info);
+    }
+    if (flags & TRACE_MEM) {
+        if (traceIsStore(info)) {
+            info.storeAddress = memAddr;
+        } else {
+            info.loadAddress = memAddr;
+        }
+    }
+    return true;
+}
+
+bool TraceReader::next(Emulator::InstructionInfo &info) {
+    if (!hasPending) return false;
+    info = pending;
+    hasPending = readRecord(pending);
+    if (hasPending) {
+        // The next retired pc is where this instruction sent control.
+        info.nextPC = pending.pc;
+        if (!info.isHalt) {
+            Emulator::decode(info.instruction, info.nextPC, info);
+        }
+    }
+    count++;
+    return true;
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <inttypes.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "emulator.h"
+
+// Binary trace of retired instructions, recorded by sim_funct and replayed by sim_cycle.
+// The file starts with TRACE_MAGIC, followed by one variable-length record per instruction:
+//   flags      one byte of TraceFlags
+//   pc delta   zigzag varint of pc - (previous pc + 4), omitted if TRACE_SEQUENTIAL
+//   word       big-endian raw instruction, omitted if TRACE_WORD_CACHED
+//   mem delta  zigzag varint of address - previous load/store address, only if TRACE_MEM
+static const char TRACE_MAGIC[] = "MIPSTRC1";
+static const uint32_t TRACE_MAGIC_LEN = 8;
+
+// Both sides remember the last word seen at each pc in a direct-mapped table of this size.
+static const uint32_t TRACE_WORD_CACHE_SIZE = 4096;
+// Trace files are read and written in chunks of this size.
+static const uint32_t TRACE_BUFFER_SIZE = 1 << 20;
+
+enum TraceFlags {
+    TRACE_SEQUENTIAL = 0x01,   // pc is the previous pc + 4
+    TRACE_WORD_CACHED = 0x02,  // raw word is the last one recorded at this pc
+    TRACE_MEM = 0x04,          // load or store, a memory address follows
+    TRACE_TAKEN = 0x08,        // branch or jump redirected the PC
+    TRACE_OVERFLOW = 0x10,     // instruction overflowed
+    TRACE_INVALID = 0x20,      // illegal instruction
+};
+
+// Returns true if the instruction is a load or store that the trace records an address for
+inline bool traceHasMemAddress(const Emulator::InstructionInfo& info) {
+    switch (info.opcode) {
+        case OP_LBU:
+        case OP_LHU:
+        case OP_LW:
+        case OP_SB:
+        case OP_SH:
+        case OP_SW:
+            return info.isValid && !info.isHalt;
+        default:
+            return false;
+    }
+}
+
+// Returns true if the instruction is a store, whose address is in storeAddress
+inline bool traceIsStore(const Emulator::InstructionInfo& info) {
+    return info.opcode == OP_SB || info.opcode == OP_SH || info.opcode == OP_SW;
+}
+
+class TraceWriter {
+   private:
+    std::ofstream out;
+    std::vector<uint8_t> buf;
+    uint32_t prevPC;
+    uint32_t prevMemAddr;
+    std::vector<uint32_t> cachedPC;
+    std::vector<uint32_t> cachedWord;
+
+    void putVarint(int32_t value);
+    void putWord(uint32_t value);
+    void flush();
+
+   public:
+    TraceWriter();
+    ~TraceWriter() { close(); }
+
+    Status open(const std::string& fileName);
+    // Appends one retired instruction, as returned by Emulator::executeInstruction()
+    void write(const Emulator::InstructionInfo& info);
+    void close();
+};
+
+class TraceReader {
+   private:
+    std::ifstream in;
+    std::vector<uint8_t> buf;
+    size_t pos;
+    uint32_t prevPC;
+    uint32_t prevMemAddr;
+    uint32_t records;
+    uint32_t count;
+    std::vector<uint32_t> cachedPC;
+    std::vector<uint32_t> cachedWord;
+
+    // One record of lookahead: an instruction's nextPC is the pc of the record after it.
+    bool hasPending;
+    Emulator::InstructionInfo pending;
+
+    bool fill(size_t needed);
+    bool getByte(uint8_t& value);
+    bool getVarint(int32_t& value);
+    bool readRecord(Emulator::InstructionInfo& info);
+
+   public:
+    TraceReader();
+
+    Status open(const std::string& fileName);
+    // Rebuilds the next retired instruction. Returns false at the end of the trace.
+    bool next(Emulator::InstructionInfo& info);
+    // Number of instructions returned by next() so far
+    uint32_t getCount() { return count; }
+};
@@ -0,0 +1,100 @@
+#include "IntervalStats.h"
+
+#include <cstdio>
+#include <iostream>
+
+#include "InstrTrace.h"
+
+using namespace std;
+
+// Column names of the stall causes, in StallCause order
+static const char* const stallKeys[NUM_STALL_CAUSES] = {
+    "retired", "stall_i_miss", "stall_d_miss", "stall_load_use", "stall_load_branch",
+    "stall_arith_branch", "stall_mul_div", "stall_exception", "stall_halt_drain",
+};
+
+IntervalWriter::IntervalWriter(uint64_t length, bool byInstructions, IntervalFormat format)
+    : format(format), byInstructions(byInstructions), length(length), nextSample(length),
+      rows(0) {}
+
+Status IntervalWriter::open(const std::string& fileName) {
+    out.open(fileName);
+    if (!out) {
+        cerr << LOG_ERROR << "Could not create interval stats file " << fileName << endl;
+        return ERROR;
+    }
+    buf.reserve(TRACE_BUFFER_SIZE + 1024);
+    if (format == INTERVAL_CSV) {
+        buf += "interval,end_cycle,end_instructions,cycles,instructions,ipc,"
+               "ic_hits,ic_misses,dc_hits,dc_misses";
+        for (int cause = STALL_I_MISS; cause < NUM_STALL_CAUSES; cause++) {
+            buf += ',';
+            buf += stallKeys[cause];
+        }
+        buf += '\n';
+    }
+    return SUCCESS;
+}
+
+void IntervalWriter::appendField(const char* key, uint64_t value) {
+    char field[64];
+    if (format == INTERVAL_CSV) {
+        snprintf(field, sizeof(field), ",%" PRIu64, value);
+    } else {
+        snprintf(field, sizeof(field), ",\"%s\":%" PRIu64, key, value);
+    }
+    buf += field;
+}
+
+void IntervalWriter::writeRow(const IntervalCounters& now) {
+    uint64_t cycles = now.cycles - prev.cycles;
+    uint64_t instructions = now.instructions - prev.instructions;
+    double ipc = cycles ? (double)instructions / cycles : 0.0;
+
+    char field[64];
+    if (format == INTERVAL_CSV) {
+        snprintf(field, sizeof(field), "%u", rows);
+    } else {
+        snprintf(field, sizeof(field), "{\"interval\":%u", rows);
+    }
+    buf += field;
+    appendField("end_cycle", now.cycles);
+    appendField("end_instructions", now.instructions);
+    appendField("cycles", cycles);
+    appendField("instructions", instructions);
+    snprintf(field, sizeof(field), format == INTERVAL_CSV ? ",%.4f" : ",\"ipc\":%.4f", ipc);
+    buf += field;
+    appendField("ic_hits", now.icHits - prev.icHits);
+    appendField("ic_misses", now.icMisses - prev.icMisses);
+    appendField("dc_hits", now.dcHits - prev.dcHits);
+    appendField("dc_misses", now.dcMisses - prev.dcMisses);
+    for (int cause = STALL_I_MISS; cause < NUM_STALL_CAUSES; cause++) {
+        appendField(stallKeys[cause], now.stalls[cause] - prev.stalls[cause]);
+    }
+    buf += format == INTERVAL_CSV ? "\n" : "}\n";
+
+    rows++;
+    prev = now;
+    if (buf.size() >= TRACE_BUFFER_SIZE) {
+        out.write(buf.data(), buf.size());
+        buf.clear();
+    }
+}
+
+void IntervalWriter::sample(const IntervalCounters& now) {
+    writeRow(now);
+    nextSample += length;
+}
+
+void IntervalWriter::finish(const IntervalCounters& now) {
+    if (!out.is_open()) return;
+    if (now.cycles != prev.cycles) writeRow(now);
+    close();
+}
+
+void IntervalWriter::close() {
+    if (!out.is_open()) return;
+    out.write(buf.data(), buf.size());
+    buf.clear();
+    out.close();
+}
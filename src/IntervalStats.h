@@ -0,0 +1,54 @@
+#pragma once
+#include <inttypes.h>
+
+#include <fstream>
+#include <string>
+
+#include "CpiStack.h"
+#include "Utilities.h"
+
+// Running totals of the simulator, sampled at the end of every interval
+struct IntervalCounters {
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t icHits = 0;
+    uint64_t icMisses = 0;
+    uint64_t dcHits = 0;
+    uint64_t dcMisses = 0;
+    uint64_t stalls[NUM_STALL_CAUSES] = {};  // STALL_NONE is unused, see instructions
+};
+
+enum IntervalFormat { INTERVAL_CSV, INTERVAL_JSONL };
+
+// Writes one row of per-interval deltas every `length` cycles or retired instructions, as
+// CSV or JSON lines. Rows are buffered and written out in TRACE_BUFFER_SIZE sized chunks.
+class IntervalWriter {
+   private:
+    std::ofstream out;
+    std::string buf;
+    IntervalFormat format;
+    bool byInstructions;
+    uint64_t length;
+    uint64_t nextSample;
+    uint32_t rows;
+    IntervalCounters prev;
+
+    void appendField(const char* key, uint64_t value);
+    void writeRow(const IntervalCounters& now);
+
+   public:
+    IntervalWriter(uint64_t length, bool byInstructions, IntervalFormat format);
+    ~IntervalWriter() { close(); }
+
+    Status open(const std::string& fileName);
+
+    // True once the current interval has run its length
+    bool isDue(uint64_t cycles, uint64_t instructions) {
+        return (byInstructions ? instructions : cycles) >= nextSample;
+    }
+    // Writes the interval ending at now and starts the next one
+    void sample(const IntervalCounters& now);
+    // Writes the last, possibly partial, interval and closes the file
+    void finish(const IntervalCounters& now);
+    void close();
+};
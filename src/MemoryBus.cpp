@@ -0,0 +1,48 @@
+#include "MemoryBus.h"
+
+#include <algorithm>
+
+using namespace std;
+
+MemoryBus::MemoryBus(uint32_t bytesPerCycleParam, BusPolicy policyParam)
+    : bytesPerCycle(bytesPerCycleParam), policy(policyParam), freeAt(0),
+      lastWinner(DRAM_DATA) {}
+
+void MemoryBus::arbitrate(uint64_t cycle, const bool missed[DRAM_SOURCES],
+                          const uint32_t blockBytes[DRAM_SOURCES],
+                          uint32_t latencies[DRAM_SOURCES]) {
+    DramSource first = DRAM_IFETCH;
+    if (policy == BUS_DATA_FIRST) first = DRAM_DATA;
+    if (policy == BUS_ROUND_ROBIN && missed[DRAM_IFETCH] && missed[DRAM_DATA]) {
+        first = lastWinner == DRAM_IFETCH ? DRAM_DATA : DRAM_IFETCH;
+    }
+    DramSource order[DRAM_SOURCES] = {first, first == DRAM_IFETCH ? DRAM_DATA : DRAM_IFETCH};
+
+    for (DramSource source : order) {
+        if (!missed[source]) continue;
+        uint32_t transfer = transferCycles(blockBytes[source]);
+        uint64_t start = std::max(cycle, freeAt);
+        uint32_t wait = start - cycle;
+        freeAt = start + transfer;
+
+        latencies[source] = wait + std::max(latencies[source], transfer);
+        stats.transfers++;
+        stats.busyCycles += transfer;
+        stats.waitCycles += wait;
+    }
+    // The winner of this cycle goes second next time both miss
+    lastWinner = missed[first] ? first : order[1];
+}
+
+bool parseBusPolicy(const std::string& text, BusPolicy& policy) {
+    if (text == "ifetch") {
+        policy = BUS_IFETCH_FIRST;
+    } else if (text == "data") {
+        policy = BUS_DATA_FIRST;
+    } else if (text == "rr") {
+        policy = BUS_ROUND_ROBIN;
+    } else {
+        return false;
+    }
+    return true;
+}
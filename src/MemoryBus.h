@@ -0,0 +1,46 @@
+#pragma once
+#include <inttypes.h>
+
+#include <string>
+
+#include "Dram.h"
+
+// Which miss gets the bus when an I-cache and a D-cache miss arrive in the same cycle
+enum BusPolicy { BUS_IFETCH_FIRST, BUS_DATA_FIRST, BUS_ROUND_ROBIN };
+
+struct BusStats {
+    uint64_t transfers = 0;
+    uint64_t busyCycles = 0;  // cycles the bus was moving a block
+    uint64_t waitCycles = 0;  // cycles misses waited for the bus
+};
+
+// Single memory port shared by the I-cache and D-cache misses of one core. Each miss moves
+// one block over the bus at bytesPerCycle, holding it for the whole transfer; a miss that
+// finds the bus busy waits. The same DramSource values name the requesters.
+class MemoryBus {
+   private:
+    uint32_t bytesPerCycle;
+    BusPolicy policy;
+    uint64_t freeAt;        // first cycle the bus is idle
+    DramSource lastWinner;  // granted first last time, for round-robin
+    BusStats stats;
+
+   public:
+    MemoryBus(uint32_t bytesPerCycleParam, BusPolicy policyParam);
+
+    // Cycles to move a block of blockBytes
+    uint32_t transferCycles(uint32_t blockBytes) {
+        return (blockBytes + bytesPerCycle - 1) / bytesPerCycle;
+    }
+
+    // Grants the bus to the misses of one cycle, in policy order. missed[source] says which
+    // sources missed and latencies[source] holds their miss latency, which is raised to cover
+    // the transfer and increased by the wait for the bus.
+    void arbitrate(uint64_t cycle, const bool missed[DRAM_SOURCES],
+                   const uint32_t blockBytes[DRAM_SOURCES], uint32_t latencies[DRAM_SOURCES]);
+
+    BusStats getStats() { return stats; }
+};
+
+// Parses ifetch, data or rr. Returns false if invalid.
+bool parseBusPolicy(const std::string& text, BusPolicy& policy);
@@ -1,50 +1,82 @@
 #include "MemoryStore.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 
 #include "Utilities.h"
 
 using namespace std;
 
-MemoryStore::MemoryStore(uint32_t startAddr, uint32_t numEntries)
-    : startAddr(startAddr) {
-    // fill memory array with 0s
-    memArr.resize(numEntries);
-    std::fill(memArr.begin(), memArr.end(), 0);
+MemoryStore::MemoryStore(uint32_t startAddr, uint64_t numEntries)
+    : startAddr(startAddr), numEntries(numEntries), pageDir(MEM_L1_ENTRIES), pageCache() {
+    // Pages are zero-filled as they are allocated, nothing to clear up front.
 
     // If we can't initialise memory appropriately, don't return a
     // MemoryStore at all.
     assert((prepareMemory(this) == 0));
 }
 
-MemoryStore::MemoryStore(uint32_t startAddr, uint32_t numEntries, const char *fileName)
-    : startAddr(startAddr) {
-    // fill memory array with 0s
-    memArr.resize(numEntries);
-    std::fill(memArr.begin(), memArr.end(), 0);
+MemoryStore::MemoryStore(uint32_t startAddr, uint64_t numEntries, const char *fileName)
+    : MemoryStore(startAddr, numEntries) {
+    loadFromFile(fileName);
+}
 
-    // If we can't initialise memory appropriately, don't return a
-    // MemoryStore at all.
-    assert((prepareMemory(this) == 0));
+MemoryStore::MemoryStore(uint32_t startAddr, uint64_t numEntries, const char *fileName,
+                         const char *initImage)
+    : startAddr(startAddr), numEntries(numEntries), pageDir(MEM_L1_ENTRIES), pageCache() {
+    if (initImage && prepareMemory(this, initImage) != 0) {
+        throw std::invalid_argument("Failed to load memory image " + std::string(initImage));
+    }
+    if (fileName && loadFromFile(fileName) != SUCCESS) {
+        throw std::invalid_argument("Failed to load program " + std::string(fileName));
+    }
+}
 
-    loadFromFile(fileName);
+MemoryStore::MemoryStore(const MemoryStore &other)
+    : startAddr(other.startAddr), numEntries(other.numEntries), pageDir(MEM_L1_ENTRIES),
+      pageCache() {
+    for (size_t dir = 0; dir < other.pageDir.size(); dir++) {
+        if (!other.pageDir[dir]) continue;
+        pageDir[dir].reset(new PageTable());
+        for (uint32_t entry = 0; entry < MEM_L2_ENTRIES; entry++) {
+            const uint8_t *page = other.pageDir[dir]->pages[entry].get();
+            if (!page) continue;
+            uint8_t *copy = new uint8_t[MEM_PAGE_SIZE];
+            memcpy(copy, page, MEM_PAGE_SIZE);
+            pageDir[dir]->pages[entry].reset(copy);
+        }
+    }
 }
 
-int prepareMemory(MemoryStore *mem) {
+int prepareMemory(MemoryStore *mem, const char *imageFile) {
     ifstream initMem;
-    initMem.open("init_mem_image", ios::in);
+    initMem.open(imageFile, ios::in | ios::binary);
+
+    // Binary images are recognised by their magic and bulk loaded.
+    char magic[MEM_IMAGE_MAGIC_LEN] = {0};
+    if (initMem.read(magic, MEM_IMAGE_MAGIC_LEN) &&
+        std::equal(magic, magic + MEM_IMAGE_MAGIC_LEN, MEM_IMAGE_MAGIC)) {
+        initMem.close();
+        return loadBinaryMemImage(mem, imageFile);
+    }
+    initMem.clear();
+    initMem.seekg(0, ios::beg);
 
     // For tests that don't require such an initial memory image, nothing is done.
-    while (initMem && mem) {
-        uint32_t curVal = 0;
-        uint32_t addr = 0;
-
-        initMem >> hex >> addr;
-        initMem >> hex >> curVal;
-
+    uint32_t curVal = 0;
+    uint32_t addr = 0;
+    while (mem && initMem >> hex >> addr >> hex >> curVal) {
         int ret = mem->setMemValue(addr, curVal, WORD_SIZE);
 
         if (ret) {
@@ -56,6 +88,166 @@ int prepareMemory(MemoryStore *mem) {
     return 0;
 }
 
+int loadBinaryMemImage(MemoryStore *mem, const char *fileName) {
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) {
+        cerr << LOG_ERROR << "Unable to open memory image " << fileName << endl;
+        return -EINVAL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) || (size_t)st.st_size < MEM_IMAGE_MAGIC_LEN) {
+        cerr << LOG_ERROR << "Truncated memory image " << fileName << endl;
+        close(fd);
+        return -EINVAL;
+    }
+
+    size_t length = st.st_size;
+    void *mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        cerr << LOG_ERROR << "Unable to map memory image " << fileName << endl;
+        return -EINVAL;
+    }
+
+    const uint8_t *data = static_cast<const uint8_t *>(mapped);
+    size_t pos = MEM_IMAGE_MAGIC_LEN;
+    int ret = 0;
+    while (mem && pos < length) {
+        if (length - pos < MEM_IMAGE_SEGMENT_HEADER) {
+            ret = -EINVAL;
+            break;
+        }
+        uint32_t segAddr, segLength;
+        memcpy(&segAddr, data + pos, sizeof(segAddr));
+        memcpy(&segLength, data + pos + 4, sizeof(segLength));
+        segAddr = ntohl(segAddr);
+        segLength = ntohl(segLength);
+        pos += MEM_IMAGE_SEGMENT_HEADER;
+
+        if (length - pos < segLength || mem->setMemBytes(segAddr, data + pos, segLength)) {
+            ret = -EINVAL;
+            break;
+        }
+        pos += segLength;
+    }
+
+    if (ret) {
+        cerr << LOG_ERROR << "Malformed memory image " << fileName << " at offset " << dec << pos
+             << endl;
+    }
+    munmap(mapped, length);
+    return ret;
+}
+
+static void writeImageWord(ostream &out, uint32_t value) {
+    uint32_t bigEndian = htonl(value);
+    out.write(reinterpret_cast<const char *>(&bigEndian), sizeof(bigEndian));
+}
+
+static void writeImageSegment(ostream &out, uint32_t addr, const vector<uint32_t> &values) {
+    writeImageWord(out, addr);
+    writeImageWord(out, values.size() * WORD_SIZE);
+    for (uint32_t value : values) writeImageWord(out, value);
+}
+
+int convertMemImage(istream &in, ostream &out, uint32_t &words, uint32_t &segments) {
+    words = 0;
+    segments = 0;
+    out.write(MEM_IMAGE_MAGIC, MEM_IMAGE_MAGIC_LEN);
+
+    uint32_t segAddr = 0;
+    vector<uint32_t> segment;
+    string line;
+    for (uint32_t lineNum = 1; getline(in, line); lineNum++) {
+        istringstream fields(line);
+        uint32_t addr = 0;
+        uint32_t value = 0;
+        string rest;
+        if (!(fields >> ws).good()) continue;  // blank line
+        if (!(fields >> hex >> addr >> hex >> value) || fields >> rest) {
+            cerr << LOG_ERROR << "Malformed memory image line " << lineNum << ": " << line
+                 << endl;
+            return -EINVAL;
+        }
+
+        // A word extends the segment only if it directly follows it, anything else starts a
+        // new one so the loader replays the writes in file order.
+        if (!segment.empty() && addr != segAddr + segment.size() * WORD_SIZE) {
+            writeImageSegment(out, segAddr, segment);
+            segment.clear();
+            segments++;
+        }
+        if (segment.empty()) segAddr = addr;
+        segment.push_back(value);
+        words++;
+        if (addr % WORD_SIZE) {
+            writeImageSegment(out, segAddr, segment);
+            segment.clear();
+            segments++;
+        }
+    }
+    if (!segment.empty()) {
+        writeImageSegment(out, segAddr, segment);
+        segments++;
+    }
+    return out ? 0 : -EINVAL;
+}
+
+uint8_t *MemoryStore::walkPages(uint32_t pageNum, bool allocate) {
+    std::unique_ptr<PageTable> &table = pageDir[pageNum >> MEM_L2_BITS];
+    if (!table) {
+        if (!allocate) return nullptr;
+        table.reset(new PageTable());
+    }
+
+    std::unique_ptr<uint8_t[]> &page = table->pages[pageNum & (MEM_L2_ENTRIES - 1)];
+    if (!page) {
+        if (!allocate) return nullptr;
+        page.reset(new uint8_t[MEM_PAGE_SIZE]());
+    }
+
+    PageCacheEntry &cached = pageCache[pageNum & (PAGE_CACHE_ENTRIES - 1)];
+    cached.pageNum = pageNum;
+    cached.page = page.get();
+    return cached.page;
+}
+
+uint8_t MemoryStore::readByte(uint32_t relativeAddr) {
+    if (relativeAddr >= numEntries) {
+        throw std::out_of_range("memory address out of range");
+    }
+    uint8_t *page = findPage(relativeAddr >> MEM_PAGE_BITS, false);
+    return page ? page[relativeAddr & MEM_PAGE_MASK] : 0;
+}
+
+void MemoryStore::writeByte(uint32_t relativeAddr, uint8_t value) {
+    if (relativeAddr >= numEntries) {
+        throw std::out_of_range("memory address out of range");
+    }
+    findPage(relativeAddr >> MEM_PAGE_BITS, true)[relativeAddr & MEM_PAGE_MASK] = value;
+}
+
+// Copies a buffer into memory starting at address, one page at a time.
+int MemoryStore::setMemBytes(uint32_t address, const uint8_t *buf, uint32_t length) {
+    uint32_t relativeAddr = address - startAddr;
+    if ((uint64_t)relativeAddr + length > numEntries) {
+        cerr << LOG_ERROR << "Access violation at address 0x" << hex << address << dec << endl;
+        return -EINVAL;
+    }
+
+    while (length > 0) {
+        uint32_t offset = relativeAddr & MEM_PAGE_MASK;
+        uint32_t chunk = std::min(length, MEM_PAGE_SIZE - offset);
+        std::copy(buf, buf + chunk, findPage(relativeAddr >> MEM_PAGE_BITS, true) + offset);
+        relativeAddr += chunk;
+        buf += chunk;
+        length -= chunk;
+    }
+
+    return 0;
+}
+
 int MemoryStore::getOrSetValue(bool get, uint32_t address, uint32_t &value, MemEntrySize size) {
     uint32_t byteSize = static_cast<uint32_t>(size);
 
@@ -70,25 +262,66 @@ int MemoryStore::getOrSetValue(bool get, uint32_t address, uint32_t &value, MemE
     }
 
     uint32_t relativeAddr = address - startAddr;
-    try {
-        if (get) {
+    if ((uint64_t)relativeAddr + byteSize > numEntries) {
+        cerr << LOG_ERROR << "Access violation at address 0x" << hex << address << dec << endl;
+        return -EINVAL;
+    }
+
+    uint32_t offset = relativeAddr & MEM_PAGE_MASK;
+    if (offset + byteSize <= MEM_PAGE_SIZE) {
+        // Common case: the whole access lies within one page.
+        uint8_t *page = findPage(relativeAddr >> MEM_PAGE_BITS, !get);
+        if (size == WORD_SIZE) {
+            // Memory is big-endian, move the word in one go
+            uint32_t word;
+            if (get) {
+                word = 0;
+                if (page) memcpy(&word, page + offset, sizeof(word));
+                value = ntohl(word);
+            } else {
+                word = htonl(value);
+                memcpy(page + offset, &word, sizeof(word));
+            }
+        } else if (get) {
             value = 0;
-            for (uint32_t i = 0; i < byteSize; ++i) {
-                value |= (memArr.at(relativeAddr + i) << ((byteSize - 1 - i) * 8));
+            if (page) {
+                for (uint32_t i = 0; i < byteSize; ++i) {
+                    value = (value << 8) | page[offset + i];
+                }
             }
         } else {
             for (uint32_t i = 0; i < byteSize; ++i) {
-                memArr.at(relativeAddr + i) = (value >> ((byteSize - 1 - i) * 8)) & 0xFF;
+                page[offset + i] = (value >> ((byteSize - 1 - i) * 8)) & 0xFF;
             }
         }
-    } catch (const std::out_of_range &e) {
-        cerr << LOG_ERROR << "Access violation at address 0x" << hex << address << endl;
-        return -EINVAL;
+        return 0;
+    }
+
+    // Unaligned access straddling a page boundary.
+    if (get) {
+        value = 0;
+        for (uint32_t i = 0; i < byteSize; ++i) {
+            value = (value << 8) | readByte(relativeAddr + i);
+        }
+    } else {
+        for (uint32_t i = 0; i < byteSize; ++i) {
+            writeByte(relativeAddr + i, (value >> ((byteSize - 1 - i) * 8)) & 0xFF);
+        }
     }
 
     return 0;
 }
 
+uint8_t MemoryStore::peekByte(uint32_t address) const {
+    uint32_t relativeAddr = address - startAddr;
+    if (relativeAddr >= numEntries) return 0;
+    uint32_t pageNum = relativeAddr >> MEM_PAGE_BITS;
+    const std::unique_ptr<PageTable> &table = pageDir[pageNum >> MEM_L2_BITS];
+    if (!table) return 0;
+    const std::unique_ptr<uint8_t[]> &page = table->pages[pageNum & (MEM_L2_ENTRIES - 1)];
+    return page ? page[relativeAddr & MEM_PAGE_MASK] : 0;
+}
+
 int MemoryStore::getMemValue(uint32_t address, uint32_t &value, MemEntrySize size) {
     return getOrSetValue(true, address, value, size);
 }
@@ -107,15 +340,13 @@ int MemoryStore::loadFromFile(const char *fileName) {
         int length = infile.tellg();
         infile.seekg(0, ios::beg);
 
-        char *buf = new char[length];
-        infile.read(buf, length);
+        vector<uint8_t> buf(length);
+        infile.read(reinterpret_cast<char *>(buf.data()), length);
         infile.close();
 
         // Initialize memory store with buffer contents
-        int memLength = length / sizeof(buf[0]);
-        int i;
-        for (i = 0; i < memLength; i++) {
-            this->setMemValue(i * BYTE_SIZE, buf[i], BYTE_SIZE);
+        if (setMemBytes(0, buf.data(), length)) {
+            return ERROR;
         }
         return SUCCESS;
     } else {
@@ -141,32 +372,49 @@ int MemoryStore::printMemArray(uint32_t startAddr, uint32_t endAddr, uint32_t en
     uint32_t relEnd = endAddr - this->startAddr;
     uint32_t curAddr = startAddr;
 
+    // Rows are formatted by hand into one large buffer that is written out in bulk. Small
+    // ranges only reserve what their rows take.
+    uint64_t entries = relStart < relEnd ? (relEnd - relStart + entrySize - 1) / entrySize : 0;
+    uint64_t rows = entriesPerRow ? (entries + entriesPerRow - 1) / entriesPerRow : 0;
+    uint64_t rowLength = 2 + WORD_WIDTH + 2 + entriesPerRow * (2 + entrySize * BYTE_WIDTH + 1) + 1;
+    std::string buf;
+    buf.reserve(std::min<uint64_t>(rows * rowLength, MEM_DUMP_BUFFER_SIZE));
+
     try {
         while (relStart < relEnd) {
-            out_stream << "0x" << hex << setfill('0') << setw(WORD_WIDTH) << curAddr << ": ";
+            buf += "0x";
+            appendHex(buf, curAddr, WORD_WIDTH);
+            buf += ": ";
             for (uint32_t i = 0; i < entriesPerRow; i++) {
                 if (relStart < relEnd) {
-                    out_stream << "0x";
+                    buf += "0x";
                     for (int j = 0; j < (int)(entrySize); j++) {
-                        out_stream << hex << setfill('0') << setw(BYTE_WIDTH)
-                                   << (uint32_t)(memArr.at(relStart + j));
+                        appendHex(buf, readByte(relStart + j), BYTE_WIDTH);
                     }
                     relStart += entrySize;
-                    out_stream << " ";
+                    buf += ' ';
                 } else {
-                    out_stream << endl;
+                    buf += '\n';
+                    out_stream.write(buf.data(), buf.size());
                     return 0;
                 }
             }
 
-            out_stream << endl;
+            buf += '\n';
             curAddr += (uint32_t)(entrySize)*entriesPerRow;
+
+            if (buf.size() >= MEM_DUMP_BUFFER_SIZE) {
+                out_stream.write(buf.data(), buf.size());
+                buf.clear();
+            }
         }
     } catch (const std::out_of_range &e) {
-        cerr << LOG_ERROR << "Access violation at address 0x" << hex << curAddr << endl;
+        out_stream.write(buf.data(), buf.size());
+        cerr << LOG_ERROR << "Access violation at address 0x" << hex << curAddr << dec << endl;
         return -EINVAL;
     }
 
+    out_stream.write(buf.data(), buf.size());
     return 0;
 }
 
@@ -174,7 +422,8 @@ int MemoryStore::printMemory(uint32_t startAddr, uint32_t endAddress) {
     return printMemArray(startAddr, endAddress, WORD_SIZE, 5, std::cout);
 }
 
-void dumpMemoryState(MemoryStore *mem, const std::string &base_output_name) {
+void dumpMemoryState(MemoryStore *mem, const std::string &base_output_name,
+                     const std::string &rangeFile) {
     uint32_t startAddr;
     uint32_t endAddr;
     startAddr = 0;
@@ -185,9 +434,9 @@ void dumpMemoryState(MemoryStore *mem, const std::string &base_output_name) {
         cerr << LOG_ERROR << "Invalid memory store passed to dump function" << endl;
     }
     ifstream memRange;
-    memRange.open("print_mem_range", ios::in);
+    if (!rangeFile.empty()) memRange.open(rangeFile, ios::in);
     // For tests that don't specify a memory range to print out, the default is used.
-    if (memRange) {
+    if (memRange.is_open()) {
         memRange >> hex >> startAddr;
         memRange >> hex >> endAddr;
     }
@@ -205,3 +454,27 @@ void dumpMemoryState(MemoryStore *mem, const std::string &base_output_name) {
         cerr << LOG_ERROR << "Could not create memory state dump file" << endl;
     }
 }
+
+int MemoryOverlay::getMemValue(uint32_t address, uint32_t &value, MemEntrySize size) {
+    value = 0;
+    for (uint32_t i = 0; i < static_cast<uint32_t>(size); ++i) {
+        auto it = bytes.find(address + i);
+        value = (value << 8) | (it != bytes.end() ? it->second : memory->peekByte(address + i));
+    }
+    return 0;
+}
+
+int MemoryOverlay::setMemValue(uint32_t address, uint32_t value, MemEntrySize size) {
+    uint32_t byteSize = static_cast<uint32_t>(size);
+    for (uint32_t i = 0; i < byteSize; ++i) {
+        bytes[address + i] = (value >> ((byteSize - 1 - i) * 8)) & 0xFF;
+    }
+    return 0;
+}
+
+void MemoryOverlay::commit() {
+    for (auto &entry : bytes) {
+        memory->setMemValue(entry.first, entry.second, BYTE_SIZE);
+    }
+    bytes.clear();
+}
@@ -1,11 +1,29 @@
 #pragma once
 #include <inttypes.h>
 
+#include <iosfwd>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
-// The memory is 64 KB large.
-#define MEMORY_SIZE 0x10000
+// The memory spans the full 32-bit address space (4 GB). Pages are only allocated once
+// they are written, so untouched memory costs nothing and reads back as zero.
+#define MEMORY_SIZE 0x100000000ULL
+
+// Memory is split into 4 KB pages, looked up through a two-level page table.
+static const uint32_t MEM_PAGE_BITS = 12;
+static const uint32_t MEM_PAGE_SIZE = 1u << MEM_PAGE_BITS;
+static const uint32_t MEM_PAGE_MASK = MEM_PAGE_SIZE - 1;
+static const uint32_t MEM_L2_BITS = 10;
+static const uint32_t MEM_L2_ENTRIES = 1u << MEM_L2_BITS;
+static const uint32_t MEM_L1_ENTRIES = 1u << (32 - MEM_PAGE_BITS - MEM_L2_BITS);
+
+// Binary init_mem_image files start with this magic, followed by any number of segments:
+// a big-endian 32-bit address, a big-endian 32-bit byte length, then the bytes themselves.
+static const char MEM_IMAGE_MAGIC[] = "MIPSMEM1";
+static const uint32_t MEM_IMAGE_MAGIC_LEN = 8;
+static const uint32_t MEM_IMAGE_SEGMENT_HEADER = 8;
 
 // The various sizes at which you can manipulate the memory.
 enum MemEntrySize { BYTE_SIZE = 1, HALF_SIZE = 2, WORD_SIZE = 4 };
@@ -14,33 +32,102 @@ static const uint32_t BYTE_SHIFT = 8;
 static const uint32_t BYTE_WIDTH = 2;
 static const uint32_t WORD_WIDTH = 8;
 
+// Memory dumps are formatted into a buffer of this size before being written out.
+static const uint32_t MEM_DUMP_BUFFER_SIZE = 1 << 22;
+
 // A memory abstraction interface. Allows values to be set and retrieved at a number of
 // different size granularities. The implementation is also capable of printing out memory
 // values over a given address range.
 class MemoryStore {
    private:
+    // Second-level table: one lazily allocated pointer per page.
+    struct PageTable {
+        std::unique_ptr<uint8_t[]> pages[MEM_L2_ENTRIES];
+    };
+
     uint32_t startAddr;
-    std::vector<uint8_t> memArr;
+    uint64_t numEntries;
+    std::vector<std::unique_ptr<PageTable>> pageDir;
 
+    // Small direct-mapped cache of recently touched pages, so instruction fetches and data
+    // accesses to different pages don't evict each other and skip the walk.
+    static const uint32_t PAGE_CACHE_ENTRIES = 16;
+    struct PageCacheEntry {
+        uint32_t pageNum;
+        uint8_t* page;
+    };
+    PageCacheEntry pageCache[PAGE_CACHE_ENTRIES];
+
+    // Returns the page with the given (relative) page number. Unmapped pages are allocated
+    // zero-filled when allocate is set, otherwise nullptr is returned.
+    uint8_t* findPage(uint32_t pageNum, bool allocate) {
+        PageCacheEntry& cached = pageCache[pageNum & (PAGE_CACHE_ENTRIES - 1)];
+        if (cached.page && pageNum == cached.pageNum) return cached.page;
+        return walkPages(pageNum, allocate);
+    }
+    // Slow path of findPage(): walks the page table and refills the page cache
+    uint8_t* walkPages(uint32_t pageNum, bool allocate);
+    uint8_t readByte(uint32_t relativeAddr);
+    void writeByte(uint32_t relativeAddr, uint8_t value);
     int getOrSetValue(bool get, uint32_t address, uint32_t& value, MemEntrySize size);
 
    public:
-    MemoryStore(uint32_t startAddr, uint32_t numEntries);
-    MemoryStore(uint32_t startAddr, uint32_t numEntries, const char* fileName);
+    MemoryStore(uint32_t startAddr, uint64_t numEntries);
+    MemoryStore(uint32_t startAddr, uint64_t numEntries, const char* fileName);
+    // Loads the initial memory image from initImage instead of the current directory, then the
+    // program from fileName. Either is skipped if null. Throws std::invalid_argument if one
+    // does not load.
+    MemoryStore(uint32_t startAddr, uint64_t numEntries, const char* fileName,
+                const char* initImage);
+    // Deep copy, so a loaded program can be reused as a template for several runs
+    MemoryStore(const MemoryStore& other);
     ~MemoryStore(){};
 
     int loadFromFile(const char* fileName);
     int getMemValue(uint32_t address, uint32_t& value, MemEntrySize size);
     int setMemValue(uint32_t address, uint32_t value, MemEntrySize size);
+    int setMemBytes(uint32_t address, const uint8_t* buf, uint32_t length);
     int printMemory(uint32_t startAddress, uint32_t endAddress);
+    // Reads one byte without allocating pages or touching the page cache, so any number
+    // of threads may peek as long as none writes.
+    uint8_t peekByte(uint32_t address) const;
     int printMemArray(uint32_t startAddr, uint32_t endAddr, uint32_t entrySize,
                       uint32_t entriesPerRow, std::ostream& out_stream);
 };
 
+// Buffers the stores of one core while the cores of a parallel run share a read-only
+// MemoryStore. Loads see the core's own buffered stores first; commit() applies them.
+class MemoryOverlay {
+   private:
+    MemoryStore* memory;
+    std::unordered_map<uint32_t, uint8_t> bytes;
+
+   public:
+    explicit MemoryOverlay(MemoryStore* mem) : memory(mem) {}
+
+    int getMemValue(uint32_t address, uint32_t& value, MemEntrySize size);
+    int setMemValue(uint32_t address, uint32_t value, MemEntrySize size);
+    // Writes the buffered stores to memory and empties the buffer
+    void commit();
+};
+
 // Creates a memory store.
 // extern MemoryStore *createMemoryStore();
 
 // Dumps the section of memory relevant for the test.
-void dumpMemoryState(MemoryStore* mem, const std::string& base_output_name);
+// The range is read from rangeFile, if present. An empty name always dumps the default range.
+void dumpMemoryState(MemoryStore* mem, const std::string& base_output_name,
+                     const std::string& rangeFile = "print_mem_range");
+
+// Loads imageFile (init_mem_image from the current directory by default), if present. Both
+// the binary segment format and the original text format (hex address/word pairs) are
+// accepted.
+int prepareMemory(MemoryStore* mem, const char* imageFile = "init_mem_image");
+
+// Loads a binary memory image (see MEM_IMAGE_MAGIC) into mem.
+int loadBinaryMemImage(MemoryStore* mem, const char* fileName);
 
-int prepareMemory(MemoryStore* mem);
+// Converts a text memory image read from in into the binary format written to out. Entries
+// keep their file order, so later writes to an address still win; only runs of contiguous
+// aligned words are merged into one segment. Returns -EINVAL on a malformed line.
+int convertMemImage(std::istream& in, std::ostream& out, uint32_t& words, uint32_t& segments);
@@ -0,0 +1,81 @@
+#include "MipsSim.h"
+
+#include <cassert>
+#include <iostream>
+
+using namespace std;
+
+MipsSim::MipsSim(const CacheConfig& icConfigParam, const CacheConfig& dcConfigParam,
+                 const SimOptions& optionsParam)
+    : icConfig(icConfigParam), dcConfig(dcConfigParam), options(optionsParam),
+      memory(new MemoryStore(0, MEMORY_SIZE, nullptr, nullptr)), halted(false), failed(false) {
+    options.fileOutput = false;
+}
+
+MipsSim::~MipsSim() {
+    // Owned by the simulator once it started
+    if (!simulator) delete memory;
+}
+
+Status MipsSim::load(const uint8_t* buffer, uint32_t length, uint32_t address) {
+    if (simulator) {
+        cerr << LOG_ERROR << "Programs can only be loaded before the first run" << endl;
+        return ERROR;
+    }
+    failed = false;
+    return memory->setMemBytes(address, buffer, length) ? ERROR : SUCCESS;
+}
+
+Status MipsSim::start() {
+    simulator.reset(new CycleSimulator());
+    Status status = simulator->init(icConfig, dcConfig, memory, "", options);
+    memory = nullptr;
+    if (status != SUCCESS) {
+        // Never step a half-built simulator. It took the memory along.
+        simulator.reset();
+        memory = new MemoryStore(0, MEMORY_SIZE, nullptr, nullptr);
+        failed = true;
+    }
+    return status;
+}
+
+Status MipsSim::run(uint32_t cycles) {
+    if (failed) return ERROR;
+    if (!simulator && start() != SUCCESS) return ERROR;
+    if (halted) return HALT;
+    Status status = cycles ? simulator->runCycles(cycles) : simulator->runTillHalt();
+    halted = status == HALT;
+    return status;
+}
+
+SimulationStats MipsSim::getStats(uint32_t core) {
+    assert(simulator);
+    return simulator->getStats(core);
+}
+
+RegisterState MipsSim::getRegisters(uint32_t core) {
+    assert(simulator);
+    RegisterState state;
+    for (uint32_t idx = 0; idx < 32; idx++) state.registers[idx] = simulator->getReg(core, idx);
+    state.pc = simulator->getPC(core);
+    return state;
+}
+
+PipeState MipsSim::getPipeState(uint32_t core) {
+    assert(simulator);
+    return simulator->getPipeState(core);
+}
+
+std::vector<uint8_t> MipsSim::readMemory(uint32_t address, uint32_t length) {
+    MemoryStore* mem = simulator ? simulator->getMemory() : memory;
+    std::vector<uint8_t> bytes(length);
+    for (uint32_t i = 0; i < length; i++) bytes[i] = mem->peekByte(address + i);
+    return bytes;
+}
+
+uint32_t MipsSim::readWord(uint32_t address) {
+    MemoryStore* mem = simulator ? simulator->getMemory() : memory;
+    uint32_t value = 0;
+    mem->getMemValue(address, value, WORD_SIZE);
+    return value;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <inttypes.h>
+
+#include <memory>
+#include <vector>
+
+#include "MemoryStore.h"
+#include "Utilities.h"
+#include "cache.h"
+#include "cycle.h"
+
+// Architectural registers of one core
+struct RegisterState {
+    uint32_t registers[32];
+    uint32_t pc;
+};
+
+// Cycle-level simulator for embedding in other programs, built as libmipssim.a. Unlike
+// sim_cycle it reads and writes no files: the program and initial data are copied in from
+// buffers, and statistics, registers and memory are returned as values.
+//
+//     MipsSim sim(icConfig, dcConfig);
+//     sim.load(program, length);
+//     sim.run();
+//     SimulationStats stats = sim.getStats();
+class MipsSim {
+   private:
+    CacheConfig icConfig;
+    CacheConfig dcConfig;
+    SimOptions options;
+    MemoryStore* memory;  // until the simulator starts and takes it over
+    std::unique_ptr<CycleSimulator> simulator;
+    bool halted;
+    bool failed;  // the simulator did not start, the program has to be loaded again
+
+    Status start();
+
+   public:
+    // interval is not supported, since it only writes to a file
+    MipsSim(const CacheConfig& icConfigParam, const CacheConfig& dcConfigParam,
+            const SimOptions& optionsParam = SimOptions());
+    ~MipsSim();
+
+    // Copies length bytes into memory at address: the program at 0, or initial data in place
+    // of init_mem_image. Only before the first run(), or after a run() that failed to start.
+    Status load(const uint8_t* buffer, uint32_t length, uint32_t address = 0);
+
+    // Runs every core for up to cycles cycles, 0 runs until they halt. Returns HALT once
+    // every core has halted, ERROR if the simulator could not start. The memory is gone
+    // then, and run() keeps failing until the next load().
+    Status run(uint32_t cycles = 0);
+    bool isHalted() { return halted; }
+
+    // Results so far. Valid after the first run().
+    SimulationStats getStats(uint32_t core = 0);
+    RegisterState getRegisters(uint32_t core = 0);
+    PipeState getPipeState(uint32_t core = 0);
+    // Copies length bytes of memory starting at address
+    std::vector<uint8_t> readMemory(uint32_t address, uint32_t length);
+    uint32_t readWord(uint32_t address);
+};
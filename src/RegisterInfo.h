@@ -41,47 +41,48 @@ struct RegisterInfo {
     uint32_t ra;
 };
 
+// Appends one "$name = 0x........" line to out.
+inline void appendRegister(std::string& out, const char* name, uint32_t value) {
+    out += name;
+    out += " = 0x";
+    appendHex(out, value, REG_OUTPUT_WIDTH);
+    out += '\n';
+}
+
+inline void appendRegisters(std::string& out, const char* prefix, const uint32_t* regs,
+                            int count) {
+    char name[4] = {prefix[0], prefix[1], 0, 0};
+    for (int i = 0; i < count; i++) {
+        name[2] = '0' + i;
+        appendRegister(out, name, regs[i]);
+    }
+    out += '\n';
+}
+
 inline Status dumpRegisterState(RegisterInfo& reg, const std::string& base_output_name) {
     ofstream reg_out(base_output_name + "_reg_state.out");
     // dumpRegisterStateInternal(reg, reg_out);
     if (reg_out) {
-        reg_out << "---------------------" << endl;
-        reg_out << "Begin Register Values" << endl;
-        reg_out << "---------------------" << endl;
-        reg_out << "$at = "
-                << "0x" << hex << setfill('0') << setw(REG_OUTPUT_WIDTH) << reg.at << endl;
-        reg_out << endl;
-        for (int i = 0; i < V_REG_SIZE; i++)
-            reg_out << "$v" << i << " = "
-                    << "0x" << hex << setfill('0') << setw(REG_OUTPUT_WIDTH) << reg.v[i] << endl;
-        reg_out << endl;
-        for (int i = 0; i < A_REG_SIZE; i++)
-            reg_out << "$a" << i << " = "
-                    << "0x" << hex << setfill('0') << setw(REG_OUTPUT_WIDTH) << reg.a[i] << endl;
-        reg_out << endl;
-        for (int i = 0; i < T_REG_SIZE; i++)
-            reg_out << "$t" << i << " = "
-                    << "0x" << hex << setfill('0') << setw(REG_OUTPUT_WIDTH) << reg.t[i] << endl;
-        reg_out << endl;
-        for (int i = 0; i < S_REG_SIZE; i++)
-            reg_out << "$s" << i << " = "
-                    << "0x" << hex << setfill('0') << setw(REG_OUTPUT_WIDTH) << reg.s[i] << endl;
-        reg_out << endl;
-        for (int i = 0; i < K_REG_SIZE; i++)
-            reg_out << "$k" << i << " = "
-                    << "0x" << hex << setfill('0') << setw(REG_OUTPUT_WIDTH) << reg.k[i] << endl;
-        reg_out << endl;
-        reg_out << "$gp = "
-                << "0x" << hex << setfill('0') << setw(REG_OUTPUT_WIDTH) << reg.gp << endl;
-        reg_out << "$sp = "
-                << "0x" << hex << setfill('0') << setw(REG_OUTPUT_WIDTH) << reg.sp << endl;
-        reg_out << "$fp = "
-                << "0x" << hex << setfill('0') << setw(REG_OUTPUT_WIDTH) << reg.fp << endl;
-        reg_out << "$ra = "
-                << "0x" << hex << setfill('0') << setw(REG_OUTPUT_WIDTH) << reg.ra << endl;
-        reg_out << "---------------------" << endl;
-        reg_out << "End Register Values" << endl;
-        reg_out << "---------------------" << endl;
+        std::string buf;
+        buf.reserve(1024);
+        buf += "---------------------\n";
+        buf += "Begin Register Values\n";
+        buf += "---------------------\n";
+        appendRegister(buf, "$at", reg.at);
+        buf += '\n';
+        appendRegisters(buf, "$v", reg.v, V_REG_SIZE);
+        appendRegisters(buf, "$a", reg.a, A_REG_SIZE);
+        appendRegisters(buf, "$t", reg.t, T_REG_SIZE);
+        appendRegisters(buf, "$s", reg.s, S_REG_SIZE);
+        appendRegisters(buf, "$k", reg.k, K_REG_SIZE);
+        appendRegister(buf, "$gp", reg.gp);
+        appendRegister(buf, "$sp", reg.sp);
+        appendRegister(buf, "$fp", reg.fp);
+        appendRegister(buf, "$ra", reg.ra);
+        buf += "---------------------\n";
+        buf += "End Register Values\n";
+        buf += "---------------------\n";
+        reg_out.write(buf.data(), buf.size());
         return SUCCESS;
     } else {
         cerr << "Could not create register state dump file" << endl;
@@ -0,0 +1,141 @@
+#include "ReuseDistance.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+// Time slots start at this many and grow with the number of distinct blocks
+static const uint32_t REUSE_MIN_SLOTS = 1 << 16;
+
+ReuseDistance::ReuseDistance(uint32_t blockSize)
+    : numOffsetBits((uint32_t)std::log2(blockSize)), tree(REUSE_MIN_SLOTS + 1), now(0),
+      histogram(), cold(0), accesses(0), intervalStart(0), intervalBlocks(0) {}
+
+void ReuseDistance::mark(uint32_t slot, int32_t delta) {
+    for (uint32_t i = slot + 1; i < tree.size(); i += i & -i) tree[i] += delta;
+}
+
+uint32_t ReuseDistance::countUpTo(uint32_t slot) {
+    uint32_t count = 0;
+    for (uint32_t i = slot + 1; i > 0; i -= i & -i) count += tree[i];
+    return count;
+}
+
+void ReuseDistance::access(uint32_t address) {
+    uint32_t block = address >> numOffsetBits;
+    accesses++;
+
+    auto it = lastAccess.find(block);
+    if (it == lastAccess.end()) {
+        cold++;
+        intervalBlocks++;
+        it = lastAccess.emplace(block, 0).first;
+    } else {
+        uint32_t last = it->second;
+        // Every marked slot is a distinct block, those after last were touched since
+        uint32_t distance = lastAccess.size() - countUpTo(last);
+        uint32_t bucket = distance ? 32 - __builtin_clz(distance) : 0;
+        histogram[bucket]++;
+        if (last < intervalStart) intervalBlocks++;
+        mark(last, -1);
+    }
+    it->second = now;
+    mark(now, 1);
+    if (++now == tree.size() - 1) compact();
+}
+
+void ReuseDistance::compact() {
+    // Renumber the live slots 0 .. n-1, keeping their order
+    vector<pair<uint32_t, uint32_t>> live;  // slot, block
+    live.reserve(lastAccess.size());
+    for (auto& entry : lastAccess) live.emplace_back(entry.second, entry.first);
+    sort(live.begin(), live.end());
+
+    uint32_t newIntervalStart = 0;
+    size_t slots = max<size_t>(REUSE_MIN_SLOTS, 4 * live.size());
+    tree.assign(slots + 1, 0);
+    for (uint32_t slot = 0; slot < live.size(); slot++) {
+        if (live[slot].first < intervalStart) newIntervalStart = slot + 1;
+        lastAccess[live[slot].second] = slot;
+        mark(slot, 1);
+    }
+    intervalStart = newIntervalStart;
+    now = live.size();
+}
+
+void ReuseDistance::endInterval() {
+    workingSets.push_back(intervalBlocks);
+    intervalStart = now;
+    intervalBlocks = 0;
+}
+
+ReuseProfiler::ReuseProfiler(uint32_t iBlockSize, uint32_t dBlockSize, uint32_t intervalLength)
+    : iStream(iBlockSize), dStream(dBlockSize), intervalLength(intervalLength), inInterval(0) {}
+
+static void dumpHistogram(ofstream& out, const char* name, ReuseDistance& stream) {
+    char line[128];
+    out << name << " reuse distance (" << stream.getBlockSize() << " byte blocks, "
+        << stream.getAccesses() << " accesses)" << endl;
+    out << "# LRU hit rate: hit rate of a fully associative LRU cache of that many blocks"
+        << endl;
+    snprintf(line, sizeof(line), "%-24s %14s %8s %14s\n", "Distance", "Accesses", "Share",
+             "LRU hit rate");
+    out << line;
+
+    double toShare = stream.getAccesses() ? 100.0 / stream.getAccesses() : 0.0;
+    snprintf(line, sizeof(line), "%-24s %14" PRIu64 " %7.2f%%\n", "cold", stream.getCold(),
+             stream.getCold() * toShare);
+    out << line;
+
+    // Stop after the last non-empty bucket
+    uint32_t lastBucket = 0;
+    for (uint32_t bucket = 0; bucket < REUSE_BUCKETS; bucket++) {
+        if (stream.getBucket(bucket)) lastBucket = bucket;
+    }
+    uint64_t hits = 0;
+    for (uint32_t bucket = 0; bucket <= lastBucket && stream.getAccesses(); bucket++) {
+        char range[48];  // two 20-digit numbers and the dash
+        if (bucket <= 1) {
+            snprintf(range, sizeof(range), "%u", bucket);
+        } else {
+            snprintf(range, sizeof(range), "%" PRIu64 "-%" PRIu64, (uint64_t)1 << (bucket - 1),
+                     ((uint64_t)1 << bucket) - 1);
+        }
+        hits += stream.getBucket(bucket);
+        snprintf(line, sizeof(line), "%-24s %14" PRIu64 " %7.2f%% %8.2f%% @ %" PRIu64 "\n",
+                 range, stream.getBucket(bucket), stream.getBucket(bucket) * toShare,
+                 hits * toShare, (uint64_t)1 << bucket);
+        out << line;
+    }
+    out << endl;
+}
+
+Status ReuseProfiler::dump(const std::string& base_output_name) {
+    ofstream out(base_output_name + "_reuse.out");
+    if (!out) {
+        cerr << LOG_ERROR << "Could not open reuse distance file!" << endl;
+        return ERROR;
+    }
+    dumpHistogram(out, "I-stream", iStream);
+    dumpHistogram(out, "D-stream", dStream);
+
+    vector<uint32_t> iSets = iStream.getWorkingSets();
+    vector<uint32_t> dSets = dStream.getWorkingSets();
+    if (inInterval) {
+        iSets.push_back(iStream.getIntervalBlocks());
+        dSets.push_back(dStream.getIntervalBlocks());
+    }
+    char line[96];
+    out << "Working set per " << intervalLength << " instructions (distinct blocks)" << endl;
+    snprintf(line, sizeof(line), "%-10s %12s %12s\n", "Interval", "I-blocks", "D-blocks");
+    out << line;
+    for (size_t i = 0; i < iSets.size(); i++) {
+        snprintf(line, sizeof(line), "%-10zu %12u %12u\n", i, iSets[i], dSets[i]);
+        out << line;
+    }
+    return SUCCESS;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <inttypes.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Utilities.h"
+
+// Reuse distances are bucketed by log2: bucket 0 holds distance 0, bucket k distances
+// [2^(k-1), 2^k). A fully associative LRU cache of 2^k blocks hits on buckets 0 .. k.
+static const uint32_t REUSE_BUCKETS = 33;
+// Working-set sizes are sampled every this many instructions
+static const uint32_t REUSE_INTERVAL = 10000;
+// Block size used for sim_funct, which has no cache config
+static const uint32_t REUSE_DEFAULT_BLOCK_SIZE = 16;
+
+// Reuse (LRU stack) distance of one address stream at block granularity: the number of
+// distinct blocks touched since the previous access to the same block. Each block's latest
+// access is marked in a Fenwick tree over time slots, so a distance is one prefix count and
+// an access costs O(log n). The slots are renumbered when they run out, which keeps the tree
+// at a few times the number of distinct blocks.
+class ReuseDistance {
+   private:
+    uint32_t numOffsetBits;
+    std::unordered_map<uint32_t, uint32_t> lastAccess;  // block -> time slot
+    std::vector<uint32_t> tree;                          // Fenwick tree, 1-based
+    uint32_t now;                                        // next time slot
+    uint64_t histogram[REUSE_BUCKETS];
+    uint64_t cold;
+    uint64_t accesses;
+
+    // Working set of the current interval: blocks whose last access is before intervalStart
+    // are new to it
+    uint32_t intervalStart;
+    uint32_t intervalBlocks;
+    std::vector<uint32_t> workingSets;
+
+    void mark(uint32_t slot, int32_t delta);
+    uint32_t countUpTo(uint32_t slot);
+    void compact();
+
+   public:
+    ReuseDistance(uint32_t blockSize);
+
+    void access(uint32_t address);
+    // Records the working set of the current interval and starts the next one
+    void endInterval();
+
+    uint64_t getBucket(uint32_t bucket) { return histogram[bucket]; }
+    uint64_t getCold() { return cold; }
+    uint64_t getAccesses() { return accesses; }
+    const std::vector<uint32_t>& getWorkingSets() { return workingSets; }
+    uint32_t getIntervalBlocks() { return intervalBlocks; }
+    uint32_t getBlockSize() { return 1u << numOffsetBits; }
+};
+
+// Reuse-distance histograms and per-interval working sets of the I and D streams
+class ReuseProfiler {
+   private:
+    ReuseDistance iStream;
+    ReuseDistance dStream;
+    uint32_t intervalLength;
+    uint32_t inInterval;
+
+   public:
+    ReuseProfiler(uint32_t iBlockSize, uint32_t dBlockSize,
+                  uint32_t intervalLength = REUSE_INTERVAL);
+
+    // Called once per instruction fetch
+    void instruction(uint32_t pc) {
+        iStream.access(pc);
+        if (++inInterval == intervalLength) {
+            iStream.endInterval();
+            dStream.endInterval();
+            inInterval = 0;
+        }
+    }
+    // Called once per load or store
+    void data(uint32_t address) { dStream.access(address); }
+
+    ReuseDistance& getIStream() { return iStream; }
+    ReuseDistance& getDStream() { return dStream; }
+
+    // Writes both histograms and the working sets, including the last partial interval, to
+    // <base>_reuse.out
+    Status dump(const std::string& base_output_name);
+};
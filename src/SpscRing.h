@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A bounded single-producer/single-consumer lock-free ring buffer. Exactly one thread may
+// call push() and exactly one other thread may call pop(). The capacity is a power of two.
+template <typename T>
+class SpscRing {
+   private:
+    std::vector<T> slots;
+    size_t mask;
+
+    // Kept on separate cache lines so producer and consumer don't false-share. Padded rather
+    // than over-aligned, so rings can live in heap-allocated objects.
+    char headPad[64];
+    std::atomic<size_t> head;  // next slot to pop, written by the consumer
+    char tailPad[64];
+    std::atomic<size_t> tail;  // next slot to push, written by the producer
+    char endPad[64];
+
+   public:
+    explicit SpscRing(uint32_t capacityLog2)
+        : slots(size_t(1) << capacityLog2), mask(slots.size() - 1), head(0), tail(0) {}
+
+    // Returns false if the ring is full.
+    bool push(const T& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == slots.size()) return false;
+        slots[t & mask] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Returns false if the ring is empty.
+    bool pop(T& value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        value = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Discards everything in the ring. Only safe while no other thread is using it.
+    void reset() {
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,65 @@
+#include "StoreBuffer.h"
+
+using namespace std;
+
+uint32_t StoreBuffer::push(uint32_t address, uint32_t size, uint64_t cycle) {
+    uint32_t wait = 0;
+    if (entries.size() == depth) {
+        // Full: the store stalls until the oldest drain completes, then takes its entry
+        const Entry& oldest = entries.front();
+        assert(oldest.draining);
+        if (oldest.doneAt > cycle) wait = oldest.doneAt - cycle;
+        drainFreeAt = oldest.doneAt;
+        entries.pop_front();
+    }
+    assert(entries.size() < depth);
+    entries.push_back(Entry{address, size, false, 0});
+    stats.stores++;
+    stats.fullCycles += wait;
+    return wait;
+}
+
+bool StoreBuffer::forwards(uint32_t address, uint32_t size) {
+    // The youngest overlapping store decides. If it only covers part of the load, the load
+    // reads the cache instead.
+    for (auto entry = entries.rbegin(); entry != entries.rend(); ++entry) {
+        if (address >= entry->address + entry->size || address + size <= entry->address) {
+            continue;
+        }
+        bool covered = address >= entry->address && address + size <= entry->address + entry->size;
+        stats.forwards += covered;
+        return covered;
+    }
+    return false;
+}
+
+void StoreBuffer::retire(uint64_t cycle) {
+    if (!entries.empty() && entries.front().draining && entries.front().doneAt <= cycle) {
+        entries.pop_front();
+    }
+}
+
+bool StoreBuffer::nextToDrain(uint32_t& address, uint64_t cycle) {
+    if (entries.empty() || entries.front().draining || cycle < drainFreeAt) return false;
+    address = entries.front().address;
+    return true;
+}
+
+void StoreBuffer::startDrain(uint64_t cycle, uint32_t latency) {
+    entries.front().draining = true;
+    entries.front().doneAt = cycle + 1 + latency;
+}
+
+uint32_t StoreBuffer::extendDrain(uint32_t cycles, uint64_t cycle) {
+    if (!entries.empty() && entries.front().draining) {
+        entries.front().doneAt += cycles;
+        return 0;
+    }
+    // The drain handed its entry to a store that found the buffer full, which waits that much
+    // longer, or it completed already
+    if (drainFreeAt >= cycle) {
+        drainFreeAt += cycles;
+        stats.fullCycles += cycles;
+    }
+    return cycles;
+}
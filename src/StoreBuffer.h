@@ -0,0 +1,57 @@
+#pragma once
+#include <inttypes.h>
+
+#include <cassert>
+#include <deque>
+
+struct StoreBufferStats {
+    uint64_t stores = 0;
+    uint64_t forwards = 0;    // loads served from a buffered store
+    uint64_t fullCycles = 0;  // cycles stores waited for a free entry
+};
+
+// FIFO of retired stores waiting to be written to the D-cache. Stores leave the MEM stage as
+// soon as they have an entry and drain to the cache one at a time in the background; only a
+// store that finds the buffer full stalls. Timing only: the Emulator has already written
+// memory.
+class StoreBuffer {
+   private:
+    struct Entry {
+        uint32_t address;
+        uint32_t size;
+        bool draining;
+        uint64_t doneAt;  // cycle the drain completes
+    };
+
+    uint32_t depth;
+    std::deque<Entry> entries;
+    // A store that found the buffer full took the entry of the oldest store before its drain
+    // completed. The next drain waits for that cycle.
+    uint64_t drainFreeAt = 0;
+    StoreBufferStats stats;
+
+   public:
+    explicit StoreBuffer(uint32_t depthParam) : depth(depthParam) { assert(depth > 0); }
+
+    // Buffers a store of size bytes. Returns the cycles it has to wait for an entry, 0 unless
+    // the buffer is full. A full buffer is always draining its oldest store, whose entry the
+    // new store takes over once the drain completes.
+    uint32_t push(uint32_t address, uint32_t size, uint64_t cycle);
+
+    // Whether a buffered store covers all bytes of a load, which then takes its data from
+    // the buffer instead of the cache
+    bool forwards(uint32_t address, uint32_t size);
+
+    // Removes the oldest store once its drain completed by cycle
+    void retire(uint64_t cycle);
+    // The oldest store, if it has not started draining and the previous drain is over by cycle
+    bool nextToDrain(uint32_t& address, uint64_t cycle);
+    // Starts draining the oldest store at cycle: one cycle to write plus latency
+    void startDrain(uint64_t cycle, uint32_t latency);
+    // Adds cycles to the drain in progress, for latency only known after it started. Returns
+    // the cycles the core has to stall instead when no drain is in progress at cycle.
+    uint32_t extendDrain(uint32_t cycles, uint64_t cycle);
+
+    bool isEmpty() { return entries.empty(); }
+    StoreBufferStats getStats() { return stats; }
+};
@@ -0,0 +1,30 @@
+#include "Tlb.h"
+
+#include <cstdlib>
+
+using namespace std;
+
+Tlb::Tlb(const TlbConfig& config, uint32_t walkLatencyParam) : walkLatency(walkLatencyParam) {
+    // size, block size, ways, miss latency
+    CacheConfig pageConfig = {config.entries * TLB_PAGE_SIZE, TLB_PAGE_SIZE, config.ways,
+                              MMU_WALK_LEVELS * walkLatency};
+    pages.reset(createCache(pageConfig, D_CACHE));
+}
+
+static bool isPowerOfTwo(unsigned long value) { return value && !(value & (value - 1)); }
+
+bool parseTlbConfig(const std::string& text, TlbConfig& config) {
+    char* end;
+    unsigned long entries = strtoul(text.c_str(), &end, 10);
+    unsigned long ways = entries;
+    if (*end == ':') {
+        ways = strtoul(end + 1, &end, 10);
+    }
+    if (*end != '\0' || !isPowerOfTwo(entries) || entries > TLB_MAX_ENTRIES ||
+        !isPowerOfTwo(ways) || ways > entries) {
+        return false;
+    }
+    config.entries = entries;
+    config.ways = ways;
+    return true;
+}
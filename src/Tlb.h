@@ -0,0 +1,48 @@
+#pragma once
+#include <inttypes.h>
+
+#include <memory>
+#include <string>
+
+#include "MemoryStore.h"
+#include "cache.h"
+
+// Pages are the 4 KB pages of MemoryStore, and a page walk reads one entry from each level of
+// a two-level table laid out like MemoryStore's own page directory (MEM_L2_BITS of the page
+// number index the second level). Translation is the identity: the MMU only adds timing.
+static const uint32_t TLB_PAGE_SIZE = MEM_PAGE_SIZE;
+static const uint32_t MMU_WALK_LEVELS = 2;
+// Cycles per level of a page walk, unless configured otherwise
+static const uint32_t MMU_DEFAULT_WALK_LATENCY = 10;
+// Upper bound for TlbConfig::entries, so the reach fits in 32 bits
+static const uint32_t TLB_MAX_ENTRIES = 65536;
+
+struct TlbConfig {
+    uint32_t entries = 0;  // 0 disables the TLB
+    uint32_t ways = 0;     // entries for fully associative
+};
+
+// Translation lookaside buffer: a cache of page numbers, using the cache models with one
+// page per block. A miss costs a page walk.
+class Tlb {
+   private:
+    std::unique_ptr<CacheModel> pages;
+    uint32_t walkLatency;
+
+   public:
+    // walkLatency is per level of the walk
+    Tlb(const TlbConfig& config, uint32_t walkLatencyParam);
+
+    // Looks up the page holding address and returns the extra cycles: 0 on a hit, the walk
+    // on a miss
+    uint32_t translate(uint32_t address) {
+        return pages->access(address, CACHE_READ) ? 0 : MMU_WALK_LEVELS * walkLatency;
+    }
+
+    uint32_t getHits() { return pages->getHits(); }
+    uint32_t getMisses() { return pages->getMisses(); }
+};
+
+// Parses a TLB geometry given as <entries>:<ways> or <entries> (fully associative). Entries
+// and ways must be powers of two with ways <= entries. Returns false if invalid.
+bool parseTlbConfig(const std::string& text, TlbConfig& config);
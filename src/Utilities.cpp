@@ -3,11 +3,13 @@
 #include <arpa/inet.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <stdio.h>
 
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <unordered_map>
 
 #define NUM_REGS 32
 
@@ -54,7 +56,13 @@ enum FUN_IDS {
     FUN_SLL  = 0x00,
     FUN_SRL  = 0x02,
     FUN_SUB  = 0x22,
-    FUN_SUBU = 0x23
+    FUN_SUBU = 0x23,
+    FUN_MFHI = 0x10,
+    FUN_MFLO = 0x12,
+    FUN_MULT = 0x18,
+    FUN_MULTU = 0x19,
+    FUN_DIV  = 0x1a,
+    FUN_DIVU = 0x1b
 };
 
 static const string regNames[NUM_REGS] = {
@@ -92,6 +100,18 @@ static string getFunString(uint8_t funct) {
             return "sub";
         case FUN_SUBU:
             return "subu";
+        case FUN_MFHI:
+            return "mfhi";
+        case FUN_MFLO:
+            return "mflo";
+        case FUN_MULT:
+            return "mult";
+        case FUN_MULTU:
+            return "multu";
+        case FUN_DIV:
+            return "div";
+        case FUN_DIVU:
+            return "divu";
         default:
             return "ILLEGAL";
     }
@@ -110,6 +130,10 @@ static void handleOpZeroInst(uint32_t instr, ostream &out_stream) {
 
     if (funct == FUN_JR) {
         sb << " " << funName << " " << regNames[rs] << " ";
+    } else if (funct == FUN_MFHI || funct == FUN_MFLO) {
+        sb << " " << funName << " " << regNames[rd] << " ";
+    } else if (funct >= FUN_MULT && funct <= FUN_DIVU) {
+        sb << " " << funName << " " << regNames[rs] << ", " << regNames[rt] << " ";
     } else if (funct == FUN_SLL || funct == FUN_SRL) {
         if (instr == 0x0) {
             sb << " nop ";
@@ -291,6 +315,41 @@ static void printInstr(uint32_t curInst, ostream &pipeState) {
     }
 }
 
+// Disassembly cache keyed by the raw instruction word. A program only has a few hundred
+// distinct words, so after warm-up every traced stage is a plain string copy. One cache per
+// thread, so parallel cores can dump their pipe state without locking.
+static thread_local unordered_map<uint32_t, string> disasmCache;
+
+// Returns the rendered, fixed-width pipe-state column for the given instruction.
+const string &getInstrColumn(uint32_t curInst) {
+    auto it = disasmCache.find(curInst);
+    if (it != disasmCache.end()) {
+        return it->second;
+    }
+
+    ostringstream column;
+    printInstr(curInst, column);
+    return disasmCache.emplace(curInst, column.str()).first->second;
+}
+
+std::string formatPipeState(const PipeState &state) {
+    char cycle[32];
+    snprintf(cycle, sizeof(cycle), "Cycle: %8u\t||", state.cycle);
+
+    string line(cycle);
+    line += getInstrColumn(state.ifInstr);
+    line += '|';
+    line += getInstrColumn(state.idInstr);
+    line += '|';
+    line += getInstrColumn(state.exInstr);
+    line += '|';
+    line += getInstrColumn(state.memInstr);
+    line += '|';
+    line += getInstrColumn(state.wbInstr);
+    line += "|\n";
+    return line;
+}
+
 Status dumpPipeState(PipeState &state, const std::string &base_output_name) {
     static auto fileInit = false;
     auto fileOp = ios::app;
@@ -301,18 +360,8 @@ Status dumpPipeState(PipeState &state, const std::string &base_output_name) {
     ofstream pipe_out(base_output_name + "_pipe_state.out", fileOp);
 
     if (pipe_out) {
-        pipe_out << "Cycle: " << std::setw(8) << state.cycle << "\t|";
-        pipe_out << "|";
-        printInstr(state.ifInstr, pipe_out);
-        pipe_out << "|";
-        printInstr(state.idInstr, pipe_out);
-        pipe_out << "|";
-        printInstr(state.exInstr, pipe_out);
-        pipe_out << "|";
-        printInstr(state.memInstr, pipe_out);
-        pipe_out << "|";
-        printInstr(state.wbInstr, pipe_out);
-        pipe_out << "|" << endl;
+        string line = formatPipeState(state);
+        pipe_out.write(line.data(), line.size());
         return SUCCESS;
     } else {
         cerr << LOG_ERROR << "Could not open pipe state file!" << endl;
@@ -331,6 +380,42 @@ Status dumpSimStats(SimulationStats &stats, const std::string &base_output_name)
         simStats << left << setw(23) << "D-cache hits: "        << stats .dcHits << endl;
         simStats << left << setw(23) << "D-cache misses: "      << stats .dcMisses << endl;
 	simStats << left << setw(23) << "Load-use stalls: "     << stats .loadStalls << endl;
+        if (stats.hasMissClasses) {
+            simStats << left << setw(23) << "I-cache compulsory: " << stats.icMissClasses.compulsory << endl;
+            simStats << left << setw(23) << "I-cache capacity: "   << stats.icMissClasses.capacity << endl;
+            simStats << left << setw(23) << "I-cache conflict: "   << stats.icMissClasses.conflict << endl;
+            simStats << left << setw(23) << "D-cache compulsory: " << stats.dcMissClasses.compulsory << endl;
+            simStats << left << setw(23) << "D-cache capacity: "   << stats.dcMissClasses.capacity << endl;
+            simStats << left << setw(23) << "D-cache conflict: "   << stats.dcMissClasses.conflict << endl;
+        }
+        if (stats.hasTlbStats) {
+            simStats << left << setw(23) << "I-TLB hits: "   << stats.itlbHits << endl;
+            simStats << left << setw(23) << "I-TLB misses: " << stats.itlbMisses << endl;
+            simStats << left << setw(23) << "D-TLB hits: "   << stats.dtlbHits << endl;
+            simStats << left << setw(23) << "D-TLB misses: " << stats.dtlbMisses << endl;
+        }
+        if (stats.hasDramStats) {
+            uint64_t average = stats.dram.requests ? stats.dram.totalLatency / stats.dram.requests : 0;
+            simStats << left << setw(23) << "DRAM requests: "      << stats.dram.requests << endl;
+            simStats << left << setw(23) << "DRAM row hits: "      << stats.dram.rowHits << endl;
+            simStats << left << setw(23) << "DRAM row misses: "    << stats.dram.rowMisses << endl;
+            simStats << left << setw(23) << "DRAM row conflicts: " << stats.dram.rowConflicts << endl;
+            simStats << left << setw(23) << "DRAM avg latency: "   << average << endl;
+        }
+        if (stats.hasBusStats) {
+            simStats << left << setw(23) << "Bus transfers: "   << stats.bus.transfers << endl;
+            simStats << left << setw(23) << "Bus busy cycles: " << stats.bus.busyCycles << endl;
+            simStats << left << setw(23) << "Bus wait cycles: " << stats.bus.waitCycles << endl;
+        }
+        if (stats.hasStoreBufferStats) {
+            simStats << left << setw(23) << "Buffered stores: "   << stats.storeBuffer.stores << endl;
+            simStats << left << setw(23) << "Forwarded loads: "   << stats.storeBuffer.forwards << endl;
+            simStats << left << setw(23) << "Store buffer full: " << stats.storeBuffer.fullCycles << endl;
+        }
+        if (stats.hasMulDivStats) {
+            simStats << left << setw(23) << "Mul/div operations: " << stats.mulDivOps << endl;
+            simStats << left << setw(23) << "Mul/div stalls: "     << stats.mulDivStalls << endl;
+        }
         return SUCCESS;
     } else {
         cerr << LOG_ERROR << "Could not open sim stats file!" << endl;
@@ -8,6 +8,10 @@
 #include <iostream>
 #include <string>
 
+#include "Dram.h"
+#include "MemoryBus.h"
+#include "StoreBuffer.h"
+
 // Utilities macro, they are very useful for debugging
 // Check sim_cycle.cpp to see how to use them!
 #define LOG_INFO \
@@ -29,6 +33,13 @@ struct PipeState {
     uint32_t wbInstr;
 };
 
+// Misses split into the 3C classes, see MissClassifier
+struct MissClassStats {
+    uint32_t compulsory = 0;
+    uint32_t capacity = 0;
+    uint32_t conflict = 0;
+};
+
 struct SimulationStats {
     uint32_t dynamicInstructions;
     uint32_t totalCycles;
@@ -38,16 +49,59 @@ struct SimulationStats {
     uint32_t dcMisses;
 // NOTE: loadStalls tracks both load-arithmetic and load-branch stalls
     uint32_t loadStalls;
+    // Only reported if the simulator classified its cache misses
+    bool hasMissClasses = false;
+    MissClassStats icMissClasses;
+    MissClassStats dcMissClasses;
+    // Only reported if the simulator modelled TLBs
+    bool hasTlbStats = false;
+    uint32_t itlbHits = 0;
+    uint32_t itlbMisses = 0;
+    uint32_t dtlbHits = 0;
+    uint32_t dtlbMisses = 0;
+    // Only reported if cache misses went to the DRAM model
+    bool hasDramStats = false;
+    DramStats dram;
+    // Only reported if misses went over the memory bus
+    bool hasBusStats = false;
+    BusStats bus;
+    // Only reported with a store buffer
+    bool hasStoreBufferStats = false;
+    StoreBufferStats storeBuffer;
+    // Only reported if the program multiplied or divided
+    bool hasMulDivStats = false;
+    uint32_t mulDivOps = 0;
+    uint32_t mulDivStalls = 0;  // cycles mult/div and mfhi/mflo waited for the unit
 };
 
 // Implemented in UtilityFunctions.o
 Status dumpPipeState(PipeState& state, const std::string& base_output_name);
+// One line of <base>_pipe_state.out
+std::string formatPipeState(const PipeState& state);
 Status dumpSimStats(SimulationStats& stats, const std::string& base_output_name);
+// Disassembly of an instruction word, padded to the 25 character pipe-state column
+const std::string& getInstrColumn(uint32_t instruction);
 
 // Endian Helpers
 inline uint32_t ConvertWordToBigEndian(uint32_t value) { return htonl(value); }
 inline uint16_t ConvertHalfWordToBigEndian(uint16_t value) { return htons(value); }
 
+// Hex formatting helpers for the state dumps, much cheaper than iostream manipulators.
+// Writes value as `digits` zero-padded lowercase hex digits at out and returns the end.
+inline char* formatHex(char* out, uint32_t value, int digits) {
+    static const char hexDigits[] = "0123456789abcdef";
+    for (int i = digits - 1; i >= 0; i--) {
+        out[i] = hexDigits[value & 0xf];
+        value >>= 4;
+    }
+    return out + digits;
+}
+
+inline void appendHex(std::string& out, uint32_t value, int digits) {
+    char buf[8];
+    out.append(buf, formatHex(buf, value, digits) - buf);
+}
+
 // handle output file names
 inline std::string getBaseFilename(const char* inputPath) {
     std::string path(inputPath);
@@ -3,11 +3,15 @@
 
 #include "cache.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <random>
+#include <sstream>
+#include <stdexcept>
 
 #include "Utilities.h"
 #include "emulator.h"
@@ -30,14 +34,39 @@ uint32_t extractBits(uint32_t address, int start, int end) {
 static std::mt19937 generator(42); // Fixed seed for deterministic results
 std::uniform_real_distribution<double> distribution(0.0, 1.0);
 
+CacheModel::CacheModel(const CacheConfig &configParam)
+    : hits(0), misses(0), config(configParam) {}
+
+CacheModel::CacheModel(CacheModel &&other) = default;
+
+CacheModel &CacheModel::operator=(CacheModel &&other) = default;
+
+CacheModel::~CacheModel() {}
+
+void CacheModel::enableMissClassification() {
+    classifier.reset(new MissClassifier(config));
+}
+
+void CacheModel::classify(uint32_t address, bool hit) { classifier->access(address, hit); }
+
+MissClassStats CacheModel::getMissClasses() {
+    return classifier ? classifier->getStats() : MissClassStats();
+}
+
+void CacheModel::enableSetStats() { setStats.reset(new SetStats(config)); }
+
+void CacheModel::recordSet(uint32_t address, bool hit) { setStats->access(address, hit); }
+
+void CacheModel::recordEviction(uint32_t blockAddress) {
+    if (setStats) setStats->evict(blockAddress);
+}
+
 // Constructor definition
 Cache::Cache(CacheConfig configParam, CacheDataType cacheType)
-    : config(configParam) {
+    : CacheModel(configParam) {
     // Here you can initialize other cache-specific attributes
     // For instance, if you had cache tables or other structures, initialize
     // them here
-    hits = 0;
-    misses = 0;
     numSets = config.cacheSize / (config.blockSize * config.ways);
     blockSize = config.blockSize;
     numWays = config.ways;
@@ -61,13 +90,45 @@ Cache::Cache(CacheConfig configParam, CacheDataType cacheType)
     }
 }
 
+void readCacheConfigs(const std::string &cacheFile, CacheConfig &icConfig,
+                      CacheConfig &dcConfig) {
+    std::ifstream file(cacheFile);
+    if (!file.is_open()) {
+        throw std::invalid_argument("Failed to open cache config file: " + cacheFile);
+    }
+
+    int line = 0;
+    auto parseNextLine = [&](const char *name) -> uint32_t {
+        line++;
+        uint32_t value;
+        if (!(file >> value)) {
+            std::stringstream errorMessage;
+            errorMessage << "Failed to parse property at line " << line << " for property "
+                         << name;
+            throw std::invalid_argument(errorMessage.str());
+        }
+        std::string discard;
+        std::getline(file, discard);  // discard rest of the line
+        return value;
+    };
+
+    icConfig = CacheConfig{parseNextLine("ICache cache size"), parseNextLine("ICache block size"),
+                           parseNextLine("ICache ways"), parseNextLine("ICache miss latency")};
+
+    dcConfig = CacheConfig{parseNextLine("DCache cache size"), parseNextLine("DCache block size"),
+                           parseNextLine("DCache ways"), parseNextLine("DCache miss latency")};
+}
+
+uint32_t Cache::getIndex(uint32_t address) {
+    return extractBits(address, 31 - numTagBits, 31 - numTagBits - numIdxBits + 1);
+}
+
 // Access method definition
 // NOTE readWrite is redundant here, ignore it Ed#376
 bool Cache::access(uint32_t address, CacheOperation readWrite) {
     bool hit = false;
     uint32_t tagVal = extractBits(address, 31, 31 - numTagBits + 1);
-    uint32_t idx =
-        extractBits(address, 31 - numTagBits, 31 - numTagBits - numIdxBits + 1);
+    uint32_t idx = getIndex(address);
     uint32_t way;
     
     for (way = 0; way < numWays; way++) {
@@ -81,16 +142,35 @@ bool Cache::access(uint32_t address, CacheOperation readWrite) {
         updateLRU(idx, way);
     } else {
         uint32_t way = findLRU(idx);
+        if (valid[idx][way]) {
+            recordEviction((tag[idx][way] << (32 - numTagBits)) |
+                           (idx << (numBlkOffsetBits + 2)));
+        }
         valid[idx][way] = 1;
         tag[idx][way] = tagVal;
         updateLRU(idx, way);
     }
 
-    hits += hit;
-    misses += !hit;
+    record(address, hit);
     return hit;
 }
 
+// Looks up a batch of read addresses. While each access is handled, the set of the access
+// CACHE_PREFETCH_DISTANCE ahead is prefetched so its tags are already in the host cache.
+uint32_t Cache::accessMany(const uint32_t *addresses, size_t count) {
+    uint32_t before = hits;
+    for (size_t i = 0; i < count; i++) {
+        if (i + CACHE_PREFETCH_DISTANCE < count) {
+            uint32_t idx = getIndex(addresses[i + CACHE_PREFETCH_DISTANCE]);
+            __builtin_prefetch(tag[idx].data());
+            __builtin_prefetch(valid[idx].data());
+            __builtin_prefetch(lru[idx].data());
+        }
+        access(addresses[i], CACHE_READ);
+    }
+    return hits - before;
+}
+
 void Cache::updateLRU(uint32_t idx, uint32_t way) {
     uint32_t oldLRU = lru[idx][way];
     for (uint32_t i = 0; i < numWays; i++) {
@@ -111,8 +191,184 @@ uint32_t Cache::findLRU(uint32_t idx) {
     assert(0);
 }
 
+HashLRUCache::HashLRUCache(const CacheConfig &configParam) : CacheModel(configParam) {
+    numSets = config.cacheSize / (config.blockSize * config.ways);
+    numWays = config.ways;
+    // Same index and tag split as the generic Cache
+    numOffsetBits = (uint32_t)(std::log2(config.blockSize / 4)) + 2;
+    indexMask = (1u << (uint32_t)(std::log2(numSets))) - 1;
+
+    ways.resize(numSets * numWays + numSets);
+    blockToWay.reserve(numSets * numWays);
+    for (uint32_t idx = 0; idx < numSets; idx++) {
+        ways[head(idx)].prev = ways[head(idx)].next = head(idx);
+        for (uint32_t way = 0; way < numWays; way++) {
+            ways[idx * numWays + way].valid = false;
+            pushFront(idx, idx * numWays + way);
+        }
+    }
+}
+
+void HashLRUCache::unlink(uint32_t way) {
+    ways[ways[way].prev].next = ways[way].next;
+    ways[ways[way].next].prev = ways[way].prev;
+}
+
+void HashLRUCache::pushFront(uint32_t idx, uint32_t way) {
+    uint32_t first = ways[head(idx)].next;
+    ways[way].prev = head(idx);
+    ways[way].next = first;
+    ways[first].prev = way;
+    ways[head(idx)].next = way;
+}
+
+bool HashLRUCache::access(uint32_t address, CacheOperation readWrite) {
+    (void)readWrite;
+    uint32_t block = address >> numOffsetBits;
+    uint32_t idx = block & indexMask;
+    uint32_t way;
+
+    auto it = blockToWay.find(block);
+    bool hit = it != blockToWay.end();
+    if (hit) {
+        way = it->second;
+    } else {
+        // Invalid ways start at the LRU end, so they are filled before anything is evicted.
+        way = ways[head(idx)].prev;
+        if (ways[way].valid) {
+            blockToWay.erase(ways[way].block);
+            recordEviction(ways[way].block << numOffsetBits);
+        }
+        ways[way].block = block;
+        ways[way].valid = true;
+        blockToWay.emplace(block, way);
+    }
+    unlink(way);
+    pushFront(idx, way);
+
+    record(address, hit);
+    return hit;
+}
+
+uint32_t HashLRUCache::accessMany(const uint32_t *addresses, size_t count) {
+    uint32_t before = hits;
+    for (size_t i = 0; i < count; i++) {
+        HashLRUCache::access(addresses[i], CACHE_READ);
+    }
+    return hits - before;
+}
+
+MissClassifier::MissClassifier(const CacheConfig &config)
+    : shadow({config.cacheSize, config.blockSize, config.cacheSize / config.blockSize,
+              config.missLatency}),
+      numOffsetBits((uint32_t)(std::log2(config.blockSize))),
+      stats() {
+    seenBlocks.reserve(config.cacheSize / config.blockSize);
+}
+
+void MissClassifier::access(uint32_t address, bool hit) {
+    // The shadow cache sees every access so its LRU order tracks the real one.
+    bool shadowHit = shadow.access(address, CACHE_READ);
+    if (hit) return;
+
+    if (seenBlocks.insert(address >> numOffsetBits).second) {
+        stats.compulsory++;
+    } else if (!shadowHit) {
+        stats.capacity++;
+    } else {
+        stats.conflict++;
+    }
+}
+
+SetStats::SetStats(const CacheConfig &config) {
+    uint32_t numSets = config.cacheSize / (config.blockSize * config.ways);
+    // Same index split as the cache models
+    numOffsetBits = (uint32_t)(std::log2(config.blockSize));
+    indexMask = (1u << (uint32_t)(std::log2(numSets))) - 1;
+    accesses.resize(indexMask + 1);
+    misses.resize(indexMask + 1);
+    evictions.resize(indexMask + 1);
+}
+
+uint64_t SetStats::getBlockEvictions(uint32_t blockAddress) {
+    auto it = blockEvictions.find(blockAddress);
+    return it == blockEvictions.end() ? 0 : it->second;
+}
+
+Status SetStats::dump(const std::string &base_output_name) {
+    ofstream heatmap(base_output_name + "_set_heatmap.csv");
+    ofstream evicted(base_output_name + "_evictions.csv");
+    if (!heatmap || !evicted) {
+        cerr << LOG_ERROR << "Could not create set stats files" << endl;
+        return ERROR;
+    }
+
+    char line[96];
+    heatmap << "set,accesses,misses,evictions,miss_rate\n";
+    for (uint32_t set = 0; set < accesses.size(); set++) {
+        snprintf(line, sizeof(line), "%u,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%.4f\n", set,
+                 accesses[set], misses[set], evictions[set],
+                 accesses[set] ? (double)misses[set] / accesses[set] : 0.0);
+        heatmap << line;
+    }
+
+    vector<pair<uint32_t, uint64_t>> blocks(blockEvictions.begin(), blockEvictions.end());
+    sort(blocks.begin(), blocks.end(), [](const pair<uint32_t, uint64_t> &lhs,
+                                          const pair<uint32_t, uint64_t> &rhs) {
+        return lhs.second != rhs.second ? lhs.second > rhs.second : lhs.first < rhs.first;
+    });
+    evicted << "block_address,set,evictions\n";
+    for (auto &block : blocks) {
+        snprintf(line, sizeof(line), "0x%08x,%u,%" PRIu64 "\n", block.first,
+                 getSet(block.first), block.second);
+        evicted << line;
+    }
+    return SUCCESS;
+}
+
+template <uint32_t Sets, uint32_t Ways>
+static CacheModel *createWithBlockSize(const CacheConfig &config) {
+    switch (config.blockSize) {
+        case 16: return new StaticCache<Sets, Ways, 16>(config);
+        case 32: return new StaticCache<Sets, Ways, 32>(config);
+        case 64: return new StaticCache<Sets, Ways, 64>(config);
+        default: return nullptr;
+    }
+}
+
+template <uint32_t Sets>
+static CacheModel *createWithWays(const CacheConfig &config) {
+    switch (config.ways) {
+        case 1: return createWithBlockSize<Sets, 1>(config);
+        case 2: return createWithBlockSize<Sets, 2>(config);
+        case 4: return createWithBlockSize<Sets, 4>(config);
+        case 8: return createWithBlockSize<Sets, 8>(config);
+        default: return nullptr;
+    }
+}
+
+CacheModel *createCache(const CacheConfig &config, CacheDataType cacheType) {
+    if (config.ways >= CACHE_HASH_WAY_THRESHOLD) return new HashLRUCache(config);
+
+    CacheModel *cache = nullptr;
+    if (config.blockSize && config.ways &&
+        config.cacheSize % (config.blockSize * config.ways) == 0) {
+        switch (config.cacheSize / (config.blockSize * config.ways)) {
+            case 16: cache = createWithWays<16>(config); break;
+            case 32: cache = createWithWays<32>(config); break;
+            case 64: cache = createWithWays<64>(config); break;
+            case 128: cache = createWithWays<128>(config); break;
+            case 256: cache = createWithWays<256>(config); break;
+            case 512: cache = createWithWays<512>(config); break;
+            case 1024: cache = createWithWays<1024>(config); break;
+        }
+    }
+    // Fall back to the runtime-configured cache for any other geometry.
+    return cache ? cache : new Cache(config, cacheType);
+}
+
 // Dump method definition, you can write your own dump info
-Status Cache::dump(const std::string &base_output_name) {
+Status CacheModel::dump(const std::string &base_output_name) {
     ofstream cache_out(base_output_name + "_cache_state.out");
     // dumpRegisterStateInternal(reg, cache_out);
     if (cache_out) {
@@ -123,13 +379,15 @@ Status Cache::dump(const std::string &base_output_name) {
         cache_out << "Size: " << config.cacheSize << " bytes" << std::endl;
         cache_out << "Block Size: " << config.blockSize << " bytes"
                   << std::endl;
-        cache_out << "Ways: " << (config.ways == 1) << std::endl;
+        cache_out << "Ways: " << config.ways << std::endl;
         cache_out << "Miss Latency: " << config.missLatency << " cycles"
                   << std::endl;
+        cache_out << "Hits: " << hits << std::endl;
+        cache_out << "Misses: " << misses << std::endl;
         cache_out << "---------------------" << endl;
         cache_out << "End Register Values" << endl;
         cache_out << "---------------------" << endl;
-        return SUCCESS;
+        return setStats ? setStats->dump(base_output_name) : SUCCESS;
     } else {
         cerr << LOG_ERROR << "Could not create cache state dump file" << endl;
         return ERROR;
@@ -2,6 +2,10 @@
 #include <inttypes.h>
 
 #include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "Utilities.h"
@@ -23,13 +27,86 @@ struct CacheConfig {
     }
 };
 
+// Reads the I-cache and D-cache configs (size, block size, ways, miss latency; one value per
+// line) from a cache config file. Throws std::invalid_argument if it can't be parsed.
+void readCacheConfigs(const std::string& cacheFile, CacheConfig& icConfig, CacheConfig& dcConfig);
+
+// How many accesses ahead accessMany() prefetches the set being looked up.
+static const size_t CACHE_PREFETCH_DISTANCE = 8;
+// Caches with at least this many ways use the hash-indexed HashLRUCache.
+static const uint32_t CACHE_HASH_WAY_THRESHOLD = 16;
+
 enum CacheDataType { I_CACHE = false, D_CACHE = true };
 enum CacheOperation { CACHE_READ = false, CACHE_WRITE = true };
 
-class Cache {
+class MissClassifier;
+class SetStats;
+
+// Interface shared by the generic runtime-configured Cache and the StaticCache
+// specializations. Use createCache() to get the fastest model for a config.
+class CacheModel {
+   protected:
+    uint32_t hits, misses;
+    // Only set once enableMissClassification() / enableSetStats() is called
+    std::unique_ptr<MissClassifier> classifier;
+    std::unique_ptr<SetStats> setStats;
+
+    // Counts one access. Every model calls this from access().
+    void record(uint32_t address, bool hit) {
+        hits += hit;
+        misses += !hit;
+        if (classifier) classify(address, hit);
+        if (setStats) recordSet(address, hit);
+    }
+    void classify(uint32_t address, bool hit);
+    void recordSet(uint32_t address, bool hit);
+    // Counts the eviction of the valid block at blockAddress, if set stats are enabled.
+    // Models call this from access() before replacing a valid block.
+    void recordEviction(uint32_t blockAddress);
+
+   public:
+    CacheConfig config;
+
+    CacheModel(const CacheConfig& configParam);
+    CacheModel(CacheModel&& other);
+    CacheModel& operator=(CacheModel&& other);
+    virtual ~CacheModel();
+
+    /** Access methods for reading/writing
+     * @return true for hit and false for miss
+     * @param
+     *      address: memory address
+     *      readWrite: true for read operation and false for write operation
+     */
+    virtual bool access(uint32_t address, CacheOperation readWrite) = 0;
+
+    /** Batched reads of count addresses, in order
+     * @return number of hits in the batch
+     */
+    virtual uint32_t accessMany(const uint32_t* addresses, size_t count) = 0;
+
+    // Writes the config and hit/miss totals to <base>_cache_state.out. With set stats enabled
+    // also writes <base>_set_heatmap.csv (one row per set) and <base>_evictions.csv (evicted
+    // blocks, most evicted first).
+    Status dump(const std::string& base_output_name);
+
+    uint32_t getHits() { return hits; }
+    uint32_t getMisses() { return misses; }
+
+    // Starts sorting every miss into compulsory, capacity and conflict misses.
+    void enableMissClassification();
+    // All zero unless miss classification is enabled
+    MissClassStats getMissClasses();
+
+    // Starts counting accesses, misses and evictions per set and evictions per block.
+    void enableSetStats();
+    // nullptr unless set stats are enabled
+    SetStats* getSetStats() { return setStats.get(); }
+};
+
+class Cache : public CacheModel {
    private:
     /**TODO[students] include other states, e.g. associativity, cache tables */
-    uint32_t hits, misses;
     uint32_t numSets;
     uint32_t blockSize;
     uint32_t numWays;
@@ -42,25 +119,165 @@ class Cache {
     std::vector<std::vector<uint32_t>> valid;
     std::vector<std::vector<uint32_t>> tag;
 
+    uint32_t getIndex(uint32_t address);
     void updateLRU(uint32_t idx, uint32_t way);
     uint32_t findLRU(uint32_t idx);
 
    public:
-    CacheConfig config;
     // Constructor to initialize the cache parameters
     Cache(CacheConfig configParam, CacheDataType cacheType);
 
-    /** Access methods for reading/writing
-     * @return true for hit and false for miss
-     * @param
-     *      address: memory address
-     *      readWrite: true for read operation and false for write operation
-     */
-    bool access(uint32_t address, CacheOperation readWrite);
+    bool access(uint32_t address, CacheOperation readWrite) override;
+    uint32_t accessMany(const uint32_t* addresses, size_t count) override;
+};
 
-    // dump information as you needed, write your own dump function
-    Status dump(const std::string& base_output_name);
+// Cache with its geometry fixed at compile time, so tag and index extraction are constant
+// shifts and masks and the way loops are unrolled. Each set keeps its tags ordered from MRU
+// to LRU, which gives the same hits and misses as the LRU counters of the generic Cache.
+template <uint32_t Sets, uint32_t Ways, uint32_t BlockBytes>
+class StaticCache : public CacheModel {
+    static_assert((Sets & (Sets - 1)) == 0, "Sets must be a power of two");
+    static_assert((BlockBytes & (BlockBytes - 1)) == 0 && BlockBytes >= 4,
+                  "BlockBytes must be a power of two of at least a word");
 
-    uint32_t getHits() { return hits; }
-    uint32_t getMisses() { return misses; }
+   private:
+    static constexpr uint32_t log2(uint32_t value) { return value <= 1 ? 0 : 1 + log2(value / 2); }
+    static const uint32_t OFFSET_BITS = log2(BlockBytes);
+    static const uint32_t INDEX_BITS = log2(Sets);
+    // Tags are at most 30 bits wide, so this never matches a real tag.
+    static const uint32_t INVALID_TAG = 0xffffffff;
+
+    struct Set {
+        uint32_t tags[Ways];  // tags[0] is the MRU block, tags[Ways - 1] the LRU one
+    };
+    std::vector<Set> sets;
+
+    static uint32_t getIndex(uint32_t address) {
+        return (address >> OFFSET_BITS) & (Sets - 1);
+    }
+
+    static uint32_t getTag(uint32_t address) { return address >> (OFFSET_BITS + INDEX_BITS); }
+
+   public:
+    StaticCache(const CacheConfig& configParam) : CacheModel(configParam), sets(Sets) {
+        for (Set& set : sets) {
+            for (uint32_t way = 0; way < Ways; way++) set.tags[way] = INVALID_TAG;
+        }
+    }
+
+    bool access(uint32_t address, CacheOperation readWrite) override {
+        (void)readWrite;
+        uint32_t* tags = sets[getIndex(address)].tags;
+        uint32_t tagVal = getTag(address);
+
+        // On a hit the block moves to the MRU position, on a miss the LRU block drops out.
+        uint32_t way = 0;
+        while (way < Ways - 1 && tags[way] != tagVal) way++;
+        bool hit = tags[way] == tagVal;
+        if (!hit && setStats && tags[way] != INVALID_TAG) {
+            recordEviction((tags[way] << (OFFSET_BITS + INDEX_BITS)) |
+                           (getIndex(address) << OFFSET_BITS));
+        }
+        for (; way > 0; way--) tags[way] = tags[way - 1];
+        tags[0] = tagVal;
+
+        record(address, hit);
+        return hit;
+    }
+
+    uint32_t accessMany(const uint32_t* addresses, size_t count) override {
+        uint32_t before = hits;
+        for (size_t i = 0; i < count; i++) {
+            if (i + CACHE_PREFETCH_DISTANCE < count) {
+                __builtin_prefetch(&sets[getIndex(addresses[i + CACHE_PREFETCH_DISTANCE])]);
+            }
+            StaticCache::access(addresses[i], CACHE_READ);
+        }
+        return hits - before;
+    }
 };
+
+// Cache for high associativity, up to fully associative. A hash map from block address to
+// way replaces the tag scan, and each set threads its ways on an intrusive doubly-linked list
+// from MRU to LRU, so lookup, hit promotion and victim selection are all O(1).
+class HashLRUCache : public CacheModel {
+   private:
+    struct Way {
+        uint32_t block;  // address >> offset bits, i.e. tag and index together
+        uint32_t prev, next;
+        bool valid;
+    };
+
+    uint32_t numSets;
+    uint32_t numWays;
+    uint32_t numOffsetBits;
+    uint32_t indexMask;
+    // numSets * numWays ways, followed by one list head per set
+    std::vector<Way> ways;
+    std::unordered_map<uint32_t, uint32_t> blockToWay;
+
+    uint32_t head(uint32_t idx) { return numSets * numWays + idx; }
+    void unlink(uint32_t way);
+    void pushFront(uint32_t idx, uint32_t way);
+
+   public:
+    HashLRUCache(const CacheConfig& configParam);
+
+    bool access(uint32_t address, CacheOperation readWrite) override;
+    uint32_t accessMany(const uint32_t* addresses, size_t count) override;
+};
+
+// Sorts the misses of a cache into the 3C classes. A miss is compulsory if the block was never
+// accessed before, capacity if a fully associative LRU cache of the same capacity misses too,
+// and conflict otherwise.
+class MissClassifier {
+   private:
+    HashLRUCache shadow;
+    std::unordered_set<uint32_t> seenBlocks;
+    uint32_t numOffsetBits;
+    MissClassStats stats;
+
+   public:
+    MissClassifier(const CacheConfig& config);
+
+    void access(uint32_t address, bool hit);
+    MissClassStats getStats() { return stats; }
+};
+
+// Per-set access, miss and eviction counts, and eviction counts per block, for finding hot
+// sets and colliding address ranges.
+class SetStats {
+   private:
+    uint32_t numOffsetBits;
+    uint32_t indexMask;
+    std::vector<uint64_t> accesses;
+    std::vector<uint64_t> misses;
+    std::vector<uint64_t> evictions;
+    std::unordered_map<uint32_t, uint64_t> blockEvictions;
+
+   public:
+    SetStats(const CacheConfig& config);
+
+    uint32_t getSet(uint32_t address) { return (address >> numOffsetBits) & indexMask; }
+    void access(uint32_t address, bool hit) {
+        uint32_t set = getSet(address);
+        accesses[set]++;
+        misses[set] += !hit;
+    }
+    void evict(uint32_t blockAddress) {
+        evictions[getSet(blockAddress)]++;
+        blockEvictions[blockAddress]++;
+    }
+
+    uint64_t getAccesses(uint32_t set) { return accesses[set]; }
+    uint64_t getMisses(uint32_t set) { return misses[set]; }
+    uint64_t getEvictions(uint32_t set) { return evictions[set]; }
+    uint64_t getBlockEvictions(uint32_t blockAddress);
+
+    Status dump(const std::string& base_output_name);
+};
+
+// Returns a StaticCache specialization for the common power-of-two geometries (16 to 1024
+// sets, 1 to 8 ways, 16 to 64 byte blocks), a HashLRUCache for CACHE_HASH_WAY_THRESHOLD or
+// more ways, or a generic Cache for anything else.
+CacheModel* createCache(const CacheConfig& config, CacheDataType cacheType);
@@ -1,13 +1,29 @@
 #include "cycle.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
 #include <cstdint>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "Coherence.h"
+#include "CpiStack.h"
+#include "Dram.h"
+#include "InstrTrace.h"
+#include "IntervalStats.h"
+#include "MemoryBus.h"
+#include "ReuseDistance.h"
+#include "SpscRing.h"
+#include "StoreBuffer.h"
 #include "Utilities.h"
 #include "cache.h"
 #include "emulator.h"
@@ -30,31 +46,196 @@ enum Stage{
     NONE
 };
 
-static Emulator* emulator = nullptr;
-static Cache* iCache = nullptr;
-static Cache* dCache = nullptr;
-static std::string output;
-static uint32_t cycleCount = 0;
-static uint32_t loadStalls = 0;
-static PipeState pipeState = {0, 0, 0, 0, 0};
-static PipeInsInfo pipeInsInfo;
-static Emulator::InstructionInfo NOP = Emulator::InstructionInfo();
+// CPI stack: each stage holds a real instruction (STALL_NONE) or a bubble tagged with the
+// cause and the instruction it is charged to. A cycle is attributed when its slot reaches WB.
+struct StageSlot {
+    StallCause cause;
+    uint32_t pc;
+    uint32_t instruction;
+};
 
+static const Emulator::InstructionInfo NOP = Emulator::InstructionInfo();
+
+// One core: an Emulator with its own pipeline, caches and statistics. Cores share memory.
+class Pipeline {
+   public:
+    Emulator* emulator = nullptr;
+    CacheModel* iCache = nullptr;
+    CacheModel* dCache = nullptr;
+    CoherentCache* coherentDCache = nullptr;  // dCache, if kept coherent with other cores
+    MemoryOverlay* overlay = nullptr;         // buffers the stores of a parallel run
+    bool halted = false;
+    std::string output;
+    uint32_t cycleCount = 0;
+    uint32_t loadStalls = 0;
+    PipeState pipeState = {0, 0, 0, 0, 0};
+    PipeInsInfo pipeInsInfo;
+    SimOptions simOptions;
+    // Pipe state trace, opened by the first writePipeState()
+    std::ofstream pipeOut;
+
+    // Decoupled mode: the emulator runs ahead on its own thread (see SimOptions::decoupled)
+    SpscRing<Emulator::InstructionInfo> instrQueue{12};
+    std::thread producer;
+    std::atomic<bool> stopProducer{false};
+
+    // Replay mode: instructions come from a recorded trace (see SimOptions::replayFile)
+    TraceReader* traceReader = nullptr;
+
+    // Hazard Detection
+    uint32_t iCacheDelay = 0;
+    uint32_t dCacheDelay = 0;
+    bool IF_stall = false;
+    bool ID_stall = false;
+    bool EX_stall = false;
+    bool MEM_stall = false;
+    bool WB_stall = false;
+    bool handlingHalt = false; // once set to true, will not be set to false again
+    bool handlingException = false;
+    Stage squashStage = NONE;
+
+    // handle loadStalls for the same dependency
+    vector<pair<uint32_t, uint32_t>> loadStallDepLut;
+
+    StageSlot stageSlots[NONE] = {{STALL_HALT_DRAIN, 0, 0}, {STALL_HALT_DRAIN, 0, 0},
+                                  {STALL_HALT_DRAIN, 0, 0}, {STALL_HALT_DRAIN, 0, 0},
+                                  {STALL_HALT_DRAIN, 0, 0}};
+    StallCause idStallCause = STALL_NONE;  // which hazard set ID_stall
+    StageSlot haltSlot;                     // charged for the NOPs fetched behind a halt
+    StageSlot exceptionSlot;                // ... and behind an excepting instruction
+    CpiStack* cpiStack = nullptr;
+
+    // Interval time series (see SimOptions::interval), sampled from the CPI stack counters
+    IntervalWriter* intervals = nullptr;
+
+    // Reuse distances of the I- and D-cache access streams (see SimOptions::reuse)
+    ReuseProfiler* reuse = nullptr;
+
+    // Address translation in front of the caches (see SimOptions::iTlb)
+    Tlb* iTlb = nullptr;
+    Tlb* dTlb = nullptr;
+
+    // Variable miss latencies (see SimOptions::dram)
+    Dram* dram = nullptr;
+    // Port shared by the I- and D-cache misses (see SimOptions::busBytesPerCycle)
+    MemoryBus* bus = nullptr;
+    // Misses of the current cycle, waiting for serviceMisses()
+    bool missed[DRAM_SOURCES] = {false, false};
+    // Stores waiting to be written to the D-cache (see SimOptions::storeBufferDepth)
+    StoreBuffer* storeBuffer = nullptr;
+
+    // Non-pipelined multiply/divide unit: busy with mulDivInstr (a din) until mulDivReadyAt
+    uint32_t mulDivInstr = UINT32_MAX;
+    uint32_t mulDivReadyAt = 0;
+    uint32_t mulDivOps = 0;
+    uint32_t mulDivStalls = 0;
+
+    ~Pipeline();
+
+    Status init(CacheConfig& iCacheConfig, CacheConfig& dCacheConfig, MemoryStore* mem,
+                CacheModel* dataCache, const std::string& output_name, const SimOptions& options);
+    void joinProducer();
+    void produceInstructions();
+    Emulator::InstructionInfo fetchInstruction();
+    void propagate(Emulator::InstructionInfo& info);
+    void stall(Stage stage, StallCause cause);
+    void squash(Stage stage);
+    void handleException();
+    void handleHalt();
+    void updateCacheDelays();
+    uint32_t missLatency(CacheModel* cache, DramSource source, uint32_t address);
+    void drainStores(bool all);
+    void serviceMisses();
+    void chargeCoherence();
+    bool hasArithmeticHazard();
+    bool hasLoadBranchHazard(Stage stage);
+    bool hasLoadUseHazard();
+    bool hasMulDivHazard();
+    bool seenLoadStall(uint32_t din1, uint32_t din2);
+    void appendLoadStall(uint32_t din1, uint32_t din2);
+    void detectHazards();
+    void resetStalls();
+    void chargeCycle();
+    IntervalCounters intervalCounters();
+    Status step();
+    void advance(uint32_t cycles, bool dumpEachCycle);
+    void writePipeState();
+    Status runCycles(uint32_t cycles, bool flush = true);
+    SimulationStats getStats();
+    Status finalize();
+};
 
-// Hazard Detection 
-static uint32_t iCacheDelay = 0;
-static uint32_t dCacheDelay = 0;
-static bool IF_stall = false;
-static bool ID_stall = false; 
-static bool EX_stall = false;
-static bool MEM_stall = false;
-static bool WB_stall = false;
-static bool handlingHalt = false; // once set to true, will not be set to false again
-static bool handlingException = false;
-static Stage squashStage = NONE;
+// Reusable barrier between the core threads of a parallel run and the thread driving them
+class QuantumBarrier {
+   private:
+    std::mutex mutex;
+    std::condition_variable released;
+    uint32_t parties;
+    uint32_t waiting = 0;
+    uint64_t generation = 0;
+
+   public:
+    explicit QuantumBarrier(uint32_t count) : parties(count) {}
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        uint64_t arrived = generation;
+        if (++waiting == parties) {
+            waiting = 0;
+            generation++;
+            released.notify_all();
+            return;
+        }
+        released.wait(lock, [&] { return generation != arrived; });
+    }
+};
 
-// handle loadStalls for the same dependency
-static vector<pair<uint32_t, uint32_t>> loadStallDepLut;
+struct CycleSimulator::State {
+    // Every core, stepped in order each cycle until it halts
+    std::vector<Pipeline*> cores;
+    // Connects the data caches of a multi-core run
+    CoherenceBus* coherenceBus = nullptr;
+    std::string baseOutput;
+    uint64_t globalCycle = 0;
+
+    // Parallel mode (see SimOptions::quantum): one host thread per core. Between two barriers
+    // every core runs quantumLength cycles on its own; the driver then commits the buffered
+    // stores and drains the coherence mailboxes, both in core order.
+    uint32_t quantum = 0;
+    std::vector<std::thread> coreThreads;
+    QuantumBarrier* barrier = nullptr;
+    uint32_t quantumLength = 0;
+    bool quantumDump = false;
+    bool stopCoreThreads = false;
+
+    ~State();
+
+    Status init(CacheConfig& iCacheConfig, CacheConfig& dCacheConfig, MemoryStore* mem,
+                const std::string& output_name, const SimOptions& options);
+    void runCoreThread(Pipeline* pipeline);
+    void stopThreads();
+    bool allHalted();
+    uint32_t quantumRemaining();
+    void runQuantum(uint32_t length, bool dumpEachCycle);
+    Status runCycles(uint32_t cycles);
+    Status runTillHalt();
+    Status finalize();
+};
+
+// Bytes read or written by a load or store
+static uint32_t accessSize(uint32_t opcode) {
+    switch (opcode) {
+        case OP_LBU:
+        case OP_SB: return BYTE_SIZE;
+        case OP_LHU:
+        case OP_SH: return HALF_SIZE;
+        default: return WORD_SIZE;
+    }
+}
+
+static StageSlot slotOf(StallCause cause, const Emulator::InstructionInfo& info) {
+    return StageSlot{cause, info.pc, info.instruction};
+}
 
 
 
@@ -66,14 +247,201 @@ static vector<pair<uint32_t, uint32_t>> loadStallDepLut;
 * A basic template is provided below but it doesn't account for all possible stalls and hazards as is
 */
 
-// initialize the emulator
-Status initSimulator(CacheConfig& iCacheConfig, CacheConfig& dCacheConfig, MemoryStore* mem,
-                    const std::string& output_name) {
+// producer thread for decoupled mode: execute until halt, pushing every instruction
+void Pipeline::produceInstructions() {
+    while (!stopProducer.load(std::memory_order_relaxed)) {
+        Emulator::InstructionInfo info = emulator->executeInstruction();
+        while (!instrQueue.push(info)) {
+            if (stopProducer.load(std::memory_order_relaxed)) return;
+            std::this_thread::yield();
+        }
+        if (info.isHalt) return;
+    }
+}
+
+// get the next instruction entering IF, either inline or from the producer thread
+Emulator::InstructionInfo Pipeline::fetchInstruction() {
+    if (traceReader) {
+        Emulator::InstructionInfo info;
+        if (!traceReader->next(info)) {
+            // A truncated trace ends the simulation as if it had halted.
+            info = Emulator::InstructionInfo();
+            info.instruction = 0xfeedfeed;
+            info.isHalt = true;
+        }
+        return info;
+    }
+    if (!simOptions.decoupled) {
+        return emulator->executeInstruction();
+    }
+    Emulator::InstructionInfo info;
+    while (!instrQueue.pop(info)) {
+        std::this_thread::yield();
+    }
+    return info;
+}
+
+// initialize one core. dataCache is the core's D-cache, owned by the pipeline from now on.
+Status Pipeline::init(CacheConfig& iCacheConfig, CacheConfig& dCacheConfig, MemoryStore* mem,
+                      CacheModel* dataCache, const std::string& output_name,
+                      const SimOptions& options) {
     output = output_name;
+    simOptions = options;
     emulator = new Emulator();
     emulator->setMemory(mem);
-    iCache = new Cache(iCacheConfig, I_CACHE);
-    dCache = new Cache(dCacheConfig, D_CACHE);
+    iCache = createCache(iCacheConfig, I_CACHE);
+    dCache = dataCache;
+    if (simOptions.cpiStack || simOptions.interval) {
+        cpiStack = new CpiStack();
+    }
+    if (simOptions.interval) {
+        intervals = new IntervalWriter(simOptions.interval, simOptions.intervalInstructions,
+                                       simOptions.intervalFormat);
+        std::string extension = simOptions.intervalFormat == INTERVAL_CSV ? ".csv" : ".jsonl";
+        if (intervals->open(output + "_intervals" + extension) != SUCCESS) return ERROR;
+    }
+    if (simOptions.classifyMisses) {
+        iCache->enableMissClassification();
+        dCache->enableMissClassification();
+    }
+    if (simOptions.setStats) {
+        iCache->enableSetStats();
+        dCache->enableSetStats();
+    }
+    if (simOptions.reuse) {
+        reuse = new ReuseProfiler(iCacheConfig.blockSize, dCacheConfig.blockSize);
+    }
+    if (simOptions.iTlb.entries) {
+        iTlb = new Tlb(simOptions.iTlb, simOptions.walkLatency);
+    }
+    if (simOptions.dTlb.entries) {
+        dTlb = new Tlb(simOptions.dTlb, simOptions.walkLatency);
+    }
+    if (simOptions.dram) {
+        dram = new Dram(simOptions.dramConfig);
+    }
+    if (simOptions.busBytesPerCycle) {
+        bus = new MemoryBus(simOptions.busBytesPerCycle, simOptions.busPolicy);
+    }
+    if (simOptions.storeBufferDepth) {
+        storeBuffer = new StoreBuffer(simOptions.storeBufferDepth);
+    }
+    if (!simOptions.replayFile.empty()) {
+        traceReader = new TraceReader();
+        return traceReader->open(simOptions.replayFile);
+    }
+    if (simOptions.decoupled) {
+        instrQueue.reset();
+        stopProducer = false;
+        producer = std::thread(&Pipeline::produceInstructions, this);
+    }
+    return SUCCESS;
+}
+
+void Pipeline::joinProducer() {
+    if (producer.joinable()) {
+        stopProducer = true;
+        producer.join();
+    }
+}
+
+Pipeline::~Pipeline() {
+    joinProducer();
+    delete emulator;
+    delete iCache;
+    delete dCache;
+    delete cpiStack;
+    delete intervals;
+    delete reuse;
+    delete iTlb;
+    delete dTlb;
+    delete dram;
+    delete bus;
+    delete storeBuffer;
+    delete traceReader;
+    delete overlay;
+}
+
+void CycleSimulator::State::runCoreThread(Pipeline* pipeline) {
+    while (true) {
+        barrier->wait();
+        if (stopCoreThreads) return;
+        pipeline->advance(quantumLength, quantumDump);
+        barrier->wait();
+    }
+}
+
+// initialize the emulator, one pipeline per core
+// Rejects option combinations the simulator does not support
+static bool validOptions(const SimOptions& options) {
+    if (options.cores == 0 || options.cores > MAX_CORES) {
+        cerr << LOG_ERROR << "Core count must be between 1 and " << MAX_CORES << endl;
+        return false;
+    }
+    if (options.storeBufferDepth && (options.dram || options.busBytesPerCycle)) {
+        cerr << LOG_ERROR << "The store buffer drains with the fixed miss latency, not with the "
+             << "DRAM or bus models" << endl;
+        return false;
+    }
+    if (!options.fileOutput && options.interval) {
+        cerr << LOG_ERROR << "Interval stats need file output" << endl;
+        return false;
+    }
+    if (options.cores > 1 && (options.decoupled || !options.replayFile.empty())) {
+        cerr << LOG_ERROR << "Decoupled and replay modes only support a single core" << endl;
+        return false;
+    }
+    return true;
+}
+
+Status CycleSimulator::State::init(CacheConfig& iCacheConfig, CacheConfig& dCacheConfig,
+                                   MemoryStore* mem, const std::string& output_name,
+                                   const SimOptions& options) {
+    if (!validOptions(options)) {
+        delete mem;  // owned by the simulator even if it does not start
+        return ERROR;
+    }
+
+    baseOutput = output_name;
+    if (options.cores > 1) {
+        coherenceBus = new CoherenceBus(options.protocol);
+    }
+    for (uint32_t core = 0; core < options.cores; core++) {
+        Pipeline* pipeline = new Pipeline();
+        cores.push_back(pipeline);
+
+        // A single core keeps the plain output names
+        if (!coherenceBus) {
+            CacheModel* dataCache = createCache(dCacheConfig, D_CACHE);
+            if (pipeline->init(iCacheConfig, dCacheConfig, mem, dataCache, output_name,
+                               options) != SUCCESS) {
+                return ERROR;
+            }
+            continue;
+        }
+        pipeline->coherentDCache = new CoherentCache(dCacheConfig, coherenceBus);
+        coherenceBus->attach(pipeline->coherentDCache);
+        if (pipeline->init(iCacheConfig, dCacheConfig, mem, pipeline->coherentDCache,
+                           output_name + "_core" + std::to_string(core), options) != SUCCESS) {
+            return ERROR;
+        }
+        // Every core runs the same program, $k0 and $k1 tell it which core it is and how many
+        pipeline->emulator->setReg(REG_CORE_ID, core);
+        pipeline->emulator->setReg(REG_CORE_COUNT, options.cores);
+    }
+
+    if (coherenceBus && options.quantum) {
+        quantum = options.quantum;
+        for (Pipeline* pipeline : cores) {
+            pipeline->overlay = new MemoryOverlay(mem);
+            pipeline->emulator->setOverlay(pipeline->overlay);
+            pipeline->coherentDCache->setDeferred(true);
+        }
+        barrier = new QuantumBarrier(cores.size() + 1);
+        for (Pipeline* pipeline : cores) {
+            coreThreads.emplace_back(&State::runCoreThread, this, pipeline);
+        }
+    }
     return SUCCESS;
 }
 
@@ -84,6 +452,7 @@ bool operator==(const Emulator::InstructionInfo& lhs, const Emulator::Instructio
            lhs.isHalt == rhs.isHalt &&
            lhs.isValid == rhs.isValid &&
            lhs.isOverflow == rhs.isOverflow &&
+           lhs.isBranchTaken == rhs.isBranchTaken &&
            lhs.instructionID == rhs.instructionID &&
            lhs.instruction == rhs.instruction &&
            lhs.opcode == rhs.opcode &&
@@ -104,7 +473,7 @@ bool operator==(const Emulator::InstructionInfo& lhs, const Emulator::Instructio
 
 
 // propagate the instructions through the pipeline with the given instruction info entering IF stage
-void propagate(Emulator::InstructionInfo& info){
+void Pipeline::propagate(Emulator::InstructionInfo& info){
     if (info == NOP) {
         assert(info.instruction == 0x0);
     }
@@ -119,13 +488,25 @@ void propagate(Emulator::InstructionInfo& info){
     pipeInsInfo.exInstr = pipeInsInfo.idInstr;   // ID -> EX
     pipeInsInfo.idInstr = pipeInsInfo.ifInstr;   // IF -> ID
     pipeInsInfo.ifInstr = info;
+
+    for (int stage = WB; stage > IF; stage--) stageSlots[stage] = stageSlots[stage - 1];
+    stageSlots[IF] = slotOf(STALL_NONE, info);
 }
 
 // stall the pipeline at the given stage
 // e.g. stall(ID) will insert a nop in the EX stage and propagate the rest of the instructions (MEM, WB)
-void stall(Stage stage) {
+// The inserted nop is charged to cause and the stalled instruction in the CPI stack.
+void Pipeline::stall(Stage stage, StallCause cause) {
     assert(stage!=WB); // cannot stall at the WB stage
 
+    if (stage != NONE) {
+        const Emulator::InstructionInfo* stalled[] = {&pipeInsInfo.ifInstr, &pipeInsInfo.idInstr,
+                                                      &pipeInsInfo.exInstr, &pipeInsInfo.memInstr};
+        StageSlot bubble = slotOf(cause, *stalled[stage]);
+        for (int later = WB; later > stage + 1; later--) stageSlots[later] = stageSlots[later - 1];
+        stageSlots[stage + 1] = bubble;
+    }
+
     switch (stage) {
         case WB: // not handling
             break;
@@ -170,7 +551,12 @@ void stall(Stage stage) {
 }
 
 // squash instruction in the given stage
-void squash(Stage stage){
+void Pipeline::squash(Stage stage){
+    const Emulator::InstructionInfo* squashed[] = {&pipeInsInfo.ifInstr, &pipeInsInfo.idInstr,
+                                                   &pipeInsInfo.exInstr, &pipeInsInfo.memInstr,
+                                                   &pipeInsInfo.wbInstr};
+    if (stage != NONE) stageSlots[stage] = slotOf(STALL_EXCEPTION, *squashed[stage]);
+
     switch (stage){
         case WB:
             pipeState.wbInstr = 0;
@@ -197,9 +583,10 @@ void squash(Stage stage){
     }
 }
 
-void handleException(){
+void Pipeline::handleException(){
     if (!handlingException){
         handlingException = pipeInsInfo.ifInstr.isOverflow || !pipeInsInfo.ifInstr.isValid;
+        if (handlingException) exceptionSlot = slotOf(STALL_EXCEPTION, pipeInsInfo.ifInstr);
     }
     if (handlingException){
         if (!pipeInsInfo.idInstr.isValid){
@@ -213,42 +600,120 @@ void handleException(){
     }
 }
 
-void handleHalt(){
-    if (!handlingHalt)
+void Pipeline::handleHalt(){
+    if (!handlingHalt) {
         handlingHalt = pipeInsInfo.ifInstr.isHalt;
+        if (handlingHalt) haltSlot = slotOf(STALL_HALT_DRAIN, pipeInsInfo.ifInstr);
+    }
 }
 
-uint32_t iCacheHitCount = 0;
-
 // Update the cache delays based on the current instruction in the pipeline.
-void updateCacheDelays() {
+void Pipeline::updateCacheDelays() {
+    if (storeBuffer) drainStores(false);
+
     // Check for new instruction cache access
     // Make sure that the inserted NOP does not cause a miss in the instruction cache
     if (!(IF_stall || ID_stall || MEM_stall || EX_stall || WB_stall) && 
         !(pipeInsInfo.ifInstr == NOP)) {
         iCacheDelay = iCache->access(pipeInsInfo.ifInstr.pc, CACHE_READ) ? 
-                     0 : iCache->config.missLatency;
+                     0 : missLatency(iCache, DRAM_IFETCH, pipeInsInfo.ifInstr.pc);
+        if (iTlb) iCacheDelay += iTlb->translate(pipeInsInfo.ifInstr.pc);
+        if (reuse) reuse->instruction(pipeInsInfo.ifInstr.pc);
     }
 
-    iCacheHitCount++;
-    // cout << "iCache ACCESS: " <<  iCacheHitCount << endl;
-
-
     // Check for new data cache access in MEM stage
     // Make sure that the inserted NOP does not cause a miss in the data cache
     if (!MEM_stall && pipeInsInfo.memInstr.isValid && !(pipeInsInfo.memInstr == NOP)) {
+        if (coherentDCache) coherentDCache->setCycle(cycleCount);
         if (pipeInsInfo.memInstr.isValid && (pipeInsInfo.memInstr.opcode == OP_LBU || pipeInsInfo.memInstr.opcode == OP_LHU || pipeInsInfo.memInstr.opcode == OP_LW)){
-            dCacheDelay = dCache->access(pipeInsInfo.memInstr.loadAddress, CACHE_READ) ? 0 : dCache->config.missLatency;
+            uint32_t size = accessSize(pipeInsInfo.memInstr.opcode);
+            if (storeBuffer && storeBuffer->forwards(pipeInsInfo.memInstr.loadAddress, size)) {
+                dCacheDelay = 0;
+            } else {
+                dCacheDelay = dCache->access(pipeInsInfo.memInstr.loadAddress, CACHE_READ) ? 0 : missLatency(dCache, DRAM_DATA, pipeInsInfo.memInstr.loadAddress);
+                if (coherentDCache) dCacheDelay += coherentDCache->getPenalty();
+            }
+            if (dTlb) dCacheDelay += dTlb->translate(pipeInsInfo.memInstr.loadAddress);
+            if (reuse) reuse->data(pipeInsInfo.memInstr.loadAddress);
         }
 
         if (pipeInsInfo.memInstr.isValid && (pipeInsInfo.memInstr.opcode == OP_SB || pipeInsInfo.memInstr.opcode == OP_SH || pipeInsInfo.memInstr.opcode == OP_SW)){
-            dCacheDelay = dCache->access(pipeInsInfo.memInstr.storeAddress, CACHE_WRITE) ? 0 : dCache->config.missLatency;
+            if (storeBuffer) {
+                // Only waits for a free entry, the cache is written when the store drains
+                dCacheDelay = storeBuffer->push(pipeInsInfo.memInstr.storeAddress,
+                                                accessSize(pipeInsInfo.memInstr.opcode), cycleCount);
+            } else {
+                dCacheDelay = dCache->access(pipeInsInfo.memInstr.storeAddress, CACHE_WRITE) ? 0 : missLatency(dCache, DRAM_DATA, pipeInsInfo.memInstr.storeAddress);
+                if (coherentDCache) dCacheDelay += coherentDCache->getPenalty();
+            }
+            if (dTlb) dCacheDelay += dTlb->translate(pipeInsInfo.memInstr.storeAddress);
+            if (reuse) reuse->data(pipeInsInfo.memInstr.storeAddress);
+        }
+    }
+
+    serviceMisses();
+}
+
+// Drains buffered stores to the D-cache one at a time, or all of them right away
+void Pipeline::drainStores(bool all) {
+    do {
+        storeBuffer->retire(all ? UINT64_MAX : cycleCount);
+        uint32_t address;
+        if (!storeBuffer->nextToDrain(address, all ? UINT64_MAX : cycleCount)) return;
+        if (coherentDCache) coherentDCache->setCycle(cycleCount, true);
+        uint32_t latency = dCache->access(address, CACHE_WRITE) ? 0 : dCache->config.missLatency;
+        if (coherentDCache) latency += coherentDCache->getPenalty();
+        storeBuffer->startDrain(cycleCount, latency);
+    } while (all);
+}
+
+// Miss latency of cache: its configured latency, or 0 with the miss left for serviceMisses()
+// if misses go to DRAM or over the bus
+uint32_t Pipeline::missLatency(CacheModel* cache, DramSource source, uint32_t address) {
+    if (!dram && !bus) return cache->config.missLatency;
+    missed[source] = true;
+    if (dram) dram->enqueue(source, address, cycleCount);
+    return 0;
+}
+
+// Adds the latencies of this cycle's misses. They go to DRAM and the bus together, so both
+// can order them.
+void Pipeline::serviceMisses() {
+    if (!missed[DRAM_IFETCH] && !missed[DRAM_DATA]) return;
+    uint32_t latencies[DRAM_SOURCES] = {iCache->config.missLatency, dCache->config.missLatency};
+    uint32_t blockBytes[DRAM_SOURCES] = {iCache->config.blockSize, dCache->config.blockSize};
+    if (dram) dram->issue(latencies);
+    if (bus) bus->arbitrate(cycleCount, missed, blockBytes, latencies);
+    if (missed[DRAM_IFETCH]) iCacheDelay += latencies[DRAM_IFETCH];
+    if (missed[DRAM_DATA]) dCacheDelay += latencies[DRAM_DATA];
+    missed[DRAM_IFETCH] = missed[DRAM_DATA] = false;
+}
+
+// Parallel runs learn what the D-cache accesses of a quantum really took at the barrier
+// after it. The difference lands on the D-cache stall in progress, which at a quantum of one
+// cycle is the stall of the access itself, or stalls the core from its next cycle. Store
+// drains take theirs in the store buffer.
+void Pipeline::chargeCoherence() {
+    int32_t correction = coherentDCache->takeCorrection(false);
+    int32_t drainCorrection = coherentDCache->takeCorrection(true);
+    if (halted) {
+        // The core would have halted that much later. Its last stores drain after the end.
+        for (int32_t count = 0; cpiStack && count < correction; count++) {
+            cpiStack->charge(STALL_D_MISS, stageSlots[WB].pc, stageSlots[WB].instruction);
         }
+        if (correction > 0) cycleCount += correction;
+        return;
     }
+    // A drain found to be faster keeps its latency
+    if (drainCorrection > 0) correction += storeBuffer->extendDrain(drainCorrection, cycleCount);
+    if (correction == 0) return;
+    int64_t remaining = (MEM_stall ? dCacheDelay + 1 : 0) + (int64_t)correction;
+    MEM_stall = remaining > 0;
+    dCacheDelay = remaining > 1 ? remaining - 1 : 0;
 }
 
 
-bool hasArithmeticHazard() {
+bool Pipeline::hasArithmeticHazard() {
     // ARITHMETIC STALLING.
 
     // check for branch in ID
@@ -256,7 +721,7 @@ bool hasArithmeticHazard() {
     // stall one until instruction reaches MEM
     OP_IDS rt_CheckOps[] = {OP_ADDI, OP_ADDIU, OP_ANDI, OP_LBU, OP_LHU, OP_LUI, OP_LW, OP_ORI, OP_SLTI, OP_SLTIU};
 
-    FUNCT_IDS rd_CheckOps[] = {FUN_ADD, FUN_ADDU, FUN_AND, FUN_NOR, FUN_OR, FUN_SLT, FUN_SLTU, FUN_SLL, FUN_SRL, FUN_SUB, FUN_SUBU};
+    FUNCT_IDS rd_CheckOps[] = {FUN_ADD, FUN_ADDU, FUN_AND, FUN_NOR, FUN_OR, FUN_SLT, FUN_SLTU, FUN_SLL, FUN_SRL, FUN_SUB, FUN_SUBU, FUN_MFHI, FUN_MFLO};
 
     bool check_rt = false;
     bool check_rd = false;
@@ -299,7 +764,7 @@ bool hasArithmeticHazard() {
 }
 
 // stage is the place where the load instruction is
-bool hasLoadBranchHazard(Stage stage) {
+bool Pipeline::hasLoadBranchHazard(Stage stage) {
     assert(stage == EX || stage == MEM);
     // Load-branch hazard detection - detection happens in ID actually
     // boolean of whether there is a branch in IF or not
@@ -335,16 +800,16 @@ bool hasLoadBranchHazard(Stage stage) {
     return stall_needed;
 }
 
-bool hasLoadUseHazard() {
+bool Pipeline::hasLoadUseHazard() {
  // LOAD STALLS ----------------------------------------
 
     // opcodes that use RT / modify RT in some way (but not the ones that have RT = something)
-    FUNCT_IDS rt_UseFunc[] = {FUN_ADD, FUN_ADDU, FUN_AND, FUN_NOR, FUN_OR, FUN_SLT, FUN_SLTU, FUN_SLL, FUN_SRL, FUN_SUB, FUN_SUBU};
+    FUNCT_IDS rt_UseFunc[] = {FUN_ADD, FUN_ADDU, FUN_AND, FUN_NOR, FUN_OR, FUN_SLT, FUN_SLTU, FUN_SLL, FUN_SRL, FUN_SUB, FUN_SUBU, FUN_MULT, FUN_MULTU, FUN_DIV, FUN_DIVU};
     // OP_IDS rt_UseOp[] = {OP_SB, OP_SH, OP_SW, OP_LBU, OP_LHU, OP_LW}; // NOTE suspicious
     OP_IDS rt_UseOp[] = {OP_SB, OP_SH, OP_SW};
     // opcodes that use RS / modify RS in some way where RS = the RT of the load word instruction (but not the ones that have RS = something)
     OP_IDS rs_UseOp[] = {OP_ADDI, OP_ADDIU, OP_ANDI, OP_ORI, OP_SLTI, OP_SLTIU, OP_LW, OP_SH, OP_SW, OP_LBU, OP_LHU, OP_SB};
-    FUNCT_IDS rs_UseFunc[] = {FUN_ADD, FUN_ADDU, FUN_AND, FUN_JR, FUN_NOR, FUN_OR, FUN_SLT, FUN_SLTU, FUN_SUB, FUN_SUBU};
+    FUNCT_IDS rs_UseFunc[] = {FUN_ADD, FUN_ADDU, FUN_AND, FUN_JR, FUN_NOR, FUN_OR, FUN_SLT, FUN_SLTU, FUN_SUB, FUN_SUBU, FUN_MULT, FUN_MULTU, FUN_DIV, FUN_DIVU};
 
     // check if the load instruction's registers are being used for rs or rt
     bool check_rt_Use = false;
@@ -389,10 +854,27 @@ bool hasLoadUseHazard() {
     return false;
 }
 
+// Structural hazard on the multiply/divide unit. Starts the unit when a mult/div has just
+// entered EX, then checks whether the mult/div or mfhi/mflo in ID could enter EX next cycle.
+bool Pipeline::hasMulDivHazard() {
+    const Emulator::InstructionInfo& ex = pipeInsInfo.exInstr;
+    if (isMulDiv(ex.opcode, ex.funct) && ex.instructionID != mulDivInstr) {
+        bool isDiv = ex.funct == FUN_DIV || ex.funct == FUN_DIVU;
+        mulDivInstr = ex.instructionID;
+        mulDivReadyAt = cycleCount + (isDiv ? simOptions.divLatency : simOptions.multLatency);
+        mulDivOps++;
+    }
+
+    const Emulator::InstructionInfo& id = pipeInsInfo.idInstr;
+    bool usesUnit = isMulDiv(id.opcode, id.funct) ||
+                    (id.opcode == OP_ZERO && (id.funct == FUN_MFHI || id.funct == FUN_MFLO));
+    return usesUnit && cycleCount + 1 < mulDivReadyAt;
+}
+
 // check if the load stall dependency between din1 and din2 already seen
 // din1 depends on din2
 // din1 is the using instruction and din2 is the loading instruction dynamic ins. ID
-bool seenLoadStall(uint32_t din1, uint32_t din2){
+bool Pipeline::seenLoadStall(uint32_t din1, uint32_t din2){
     for (pair<uint32_t, uint32_t> loadStallDep : loadStallDepLut){
         if (loadStallDep.first == din1 && loadStallDep.second == din2){
             return true;
@@ -403,21 +885,21 @@ bool seenLoadStall(uint32_t din1, uint32_t din2){
 
 // append the load stall dependency between din1 and din2
 // keep track of the last 5 dependencies (# stages = 5, a very loose bound)
-void appendLoadStall(uint32_t din1, uint32_t din2){
+void Pipeline::appendLoadStall(uint32_t din1, uint32_t din2){
     assert(!seenLoadStall(din1, din2));
     assert(loadStallDepLut.size() <= 5);
-    // cout << "appending load stall " << din1 << " " << din2 << endl;
     if (loadStallDepLut.size() == 5){
         loadStallDepLut.erase(loadStallDepLut.begin());
     }
     loadStallDepLut.push_back(make_pair(din1, din2));
 }
 
-void detectHazards() {
+void Pipeline::detectHazards() {
     // Reset hazard stall signals
     bool load_use_stall = false;
     bool load_branch_stall = false; // only happens once
     bool arithmetic_stall = false;
+    bool mul_div_stall = hasMulDivHazard();
 
     // NOTE check if hazard already detected when having multiple stalls 
     // need some bookeeping in InstructionInfo.instructionID
@@ -439,8 +921,6 @@ void detectHazards() {
     if ((pipeInsInfo.exInstr.opcode == OP_LBU || pipeInsInfo.exInstr.opcode == OP_LHU || pipeInsInfo.exInstr.opcode == OP_LW)) {
         if (hasLoadBranchHazard(EX)) {
             load_branch_stall = true;
-            // cout << "Cycle " << cycleCount << endl;
-            // cout << "Checking load branch when load in EX; din=" << pipeInsInfo.exInstr.instructionID << endl;
             if (!seenLoadStall(pipeInsInfo.exInstr.instructionID, pipeInsInfo.idInstr.instructionID)){
                 appendLoadStall(pipeInsInfo.exInstr.instructionID, pipeInsInfo.idInstr.instructionID);
                 loadStalls++;
@@ -451,8 +931,6 @@ void detectHazards() {
     if ((pipeInsInfo.memInstr.opcode == OP_LBU || pipeInsInfo.memInstr.opcode == OP_LHU || pipeInsInfo.memInstr.opcode == OP_LW)) {
         if (hasLoadBranchHazard(MEM)) {
             load_branch_stall = true;
-            // cout << "Cycle " << cycleCount << endl;
-            // cout << "Checking load branch when load in MEM; din=" << pipeInsInfo.memInstr.instructionID << endl;
 
             if (!seenLoadStall(pipeInsInfo.memInstr.instructionID, pipeInsInfo.idInstr.instructionID)){
                 appendLoadStall(pipeInsInfo.memInstr.instructionID, pipeInsInfo.idInstr.instructionID);
@@ -468,13 +946,24 @@ void detectHazards() {
         }
     }
     
+    // Remember the hazard for the CPI stack, load-use first as in the loadStalls counter
+    if (load_use_stall) {
+        idStallCause = STALL_LOAD_USE;
+    } else if (load_branch_stall) {
+        idStallCause = STALL_LOAD_BRANCH;
+    } else if (arithmetic_stall) {
+        idStallCause = STALL_ARITH_BRANCH;
+    } else if (mul_div_stall) {
+        idStallCause = STALL_MUL_DIV;
+    }
+
     // Update stall signals based on hazards
     // EX_stall = EX_stall || load_use_stall;
-    ID_stall = ID_stall || arithmetic_stall || load_use_stall || load_branch_stall; // stalls once??????
+    ID_stall = ID_stall || arithmetic_stall || load_use_stall || load_branch_stall || mul_div_stall; // stalls once??????
     // IF_stall = IF_stall || load_branch_stall;
 }
 
-void resetStalls(){
+void Pipeline::resetStalls(){
     IF_stall = false;
     ID_stall = false;
     EX_stall = false;
@@ -482,6 +971,29 @@ void resetStalls(){
     WB_stall = false;
 }
 
+// attribute the current cycle to whatever reached WB
+void Pipeline::chargeCycle() {
+    if (cpiStack) {
+        const StageSlot& slot = stageSlots[WB];
+        cpiStack->charge(slot.cause, slot.pc, slot.instruction);
+    }
+}
+
+// the running totals the interval time series takes its deltas from
+IntervalCounters Pipeline::intervalCounters() {
+    IntervalCounters counters;
+    counters.cycles = cycleCount;
+    counters.instructions = cpiStack->getCycles(STALL_NONE);
+    counters.icHits = iCache->getHits();
+    counters.icMisses = iCache->getMisses();
+    counters.dcHits = dCache->getHits();
+    counters.dcMisses = dCache->getMisses();
+    for (int cause = 0; cause < NUM_STALL_CAUSES; cause++) {
+        counters.stalls[cause] = cpiStack->getCycles(static_cast<StallCause>(cause));
+    }
+    return counters;
+}
+
 /* 6 step process
  * 1. Update the pipeline state based on current stall signals set. Handle exceptions and check for halt conditions.
  * 2. Update the cache delays based on the current instruction in the pipeline.
@@ -492,90 +1004,181 @@ void resetStalls(){
 
 
  */ 
-Status runCycles(uint32_t cycles) {
-    uint32_t count = 0;
-    auto status = SUCCESS;    
+Status Pipeline::step() {
+    // Emulator::InstructionInfo info = emulator->executeInstruction();
+    pipeState.cycle = cycleCount;  // get the execution cycle count
+
+    // 1. Update the pipeline state based on current stall signals set. Handle exceptions and check for halt conditions.
+
+    if (IF_stall || ID_stall || MEM_stall || EX_stall || WB_stall) {
+        if (MEM_stall) {
+            stall(MEM, STALL_D_MISS);
+        } else if (EX_stall) {
+            stall(EX, idStallCause);
+        } else if (ID_stall) {
+            stall(ID, idStallCause);
+            if (idStallCause == STALL_MUL_DIV) mulDivStalls++;
+        } else if (IF_stall) {
+            stall(IF, STALL_I_MISS);
+        }
+        chargeCycle();
+    } else {
+        // for excepting handling
+        if (squashStage != NONE) {
+            squash(squashStage);
+            squashStage = NONE;
+        }
 
-    while (cycles == 0 || count < cycles) {
+        // No stalls -> fetch the next instruction
+        Emulator::InstructionInfo info = (handlingHalt || handlingException) ? NOP : fetchInstruction();
+        propagate(info);
+        if (handlingHalt || handlingException) {
+            stageSlots[IF] = handlingHalt ? haltSlot : exceptionSlot;
+        }
+        chargeCycle();
+
+        // Check for halt condition
+        // set status to HALT when the WB instruction is HALT
+        if (pipeInsInfo.wbInstr.isHalt) {
+            // The stores still buffered reach the cache after the program ends
+            if (storeBuffer) drainStores(true);
+            cycleCount ++;
+            return HALT;
+        }
+    }        
 
-        // Emulator::InstructionInfo info = emulator->executeInstruction();
-        pipeState.cycle = cycleCount;  // get the execution cycle count
-
-        // 1. Update the pipeline state based on current stall signals set. Handle exceptions and check for halt conditions.
-        // cout << "Cycle count " << cycleCount << "|| IF: " << IF_stall << " ID: " << ID_stall << " EX: " << EX_stall << " MEM: " << MEM_stall << " WB: " << WB_stall << endl; 
-
-        if (IF_stall || ID_stall || MEM_stall || EX_stall || WB_stall) {
-            // cout << "STALLING" << endl;
-            if (MEM_stall) {
-                stall(MEM);
-            } else if (EX_stall) {
-                stall(EX);
-            } else if (ID_stall) {
-                stall(ID);
-            } else if (IF_stall) {
-                stall(IF);
-            }
-        } else {
-            // for excepting handling
-            if (squashStage != NONE) {
-                squash(squashStage);
-                squashStage = NONE;
-            }
 
-            // No stalls -> fetch the next instruction
-            Emulator::InstructionInfo info = (handlingHalt || handlingException) ? NOP : emulator->executeInstruction();
-            propagate(info);
-
-            // Check for halt condition
-            // set status to HALT when the WB instruction is HALT
-            if (pipeInsInfo.wbInstr.isHalt) {
-                status = HALT;
-                count ++;
-                cycleCount ++;
-                break;
-            }
-        }        
+    // 2. Update the cache delays based on the current instruction in the pipeline.
+    updateCacheDelays();
 
+    // remember to reset all the stalls here 
+    resetStalls();
 
-        // 2. Update the cache delays based on the current instruction in the pipeline.
-        updateCacheDelays();
+    // 3. Set stall signals based on cache misses
+    IF_stall = iCacheDelay > 0;
+    MEM_stall = dCacheDelay > 0;
+    // 4. Hazards
+    detectHazards();
 
-        // remember to reset all the stalls here 
-        resetStalls();
+    // 5. Handle cache delays
+    if (iCacheDelay > 0) iCacheDelay--;   
+    if (dCacheDelay > 0) dCacheDelay--;
 
-        // 3. Set stall signals based on cache misses
-        IF_stall = iCacheDelay > 0;
-        MEM_stall = dCacheDelay > 0;
-        // cout << "iCache Delay: " << iCacheDelay << " dCache Delay: " << dCacheDelay << endl;    
-        // 4. Hazards
-        detectHazards();
+    // handle halt according to handlingHalt and IF instruction
+    handleHalt();
 
-        // 5. Handle cache delays
-        if (iCacheDelay > 0) iCacheDelay--;   
-        if (dCacheDelay > 0) dCacheDelay--;
+    // handle exception according to handlingException and IF instruction
+    // reset handlingException and squash instruction when the excepting instruction reaches the stage being detected
+    handleException();
 
-        // handle halt according to handlingHalt and IF instruction
-        handleHalt();
+    // 6. Update counters and dump state
+    cycleCount++;
+    if (intervals && intervals->isDue(cycleCount, cpiStack->getCycles(STALL_NONE))) {
+        intervals->sample(intervalCounters());
+    }
+    return SUCCESS;
+}
 
-        // handle exception according to handlingException and IF instruction
-        // reset handlingException and squash instruction when the excepting instruction reaches the stage being detected
-        handleException();
+Status Pipeline::runCycles(uint32_t cycles, bool flush) {
+    uint32_t count = 0;
+    auto status = SUCCESS;
 
-        // 6. Update counters and dump state
+    while (cycles == 0 || count < cycles) {
         count++;
-        cycleCount++;
-        // dumpPipeState(pipeState, output);
+        status = step();
+        if (status == HALT) break;
     }
-    dumpPipeState(pipeState, output);
-    // Not exactly the right way, just a demonstration here
+    writePipeState();
+    if (flush) pipeOut.flush();
     return status;
+}
 
+// append the current pipe state to <output>_pipe_state.out, which the first call truncates
+void Pipeline::writePipeState() {
+    if (!simOptions.fileOutput) return;
+    if (!pipeOut.is_open()) {
+        pipeOut.open(output + "_pipe_state.out");
+        if (!pipeOut) cerr << LOG_ERROR << "Could not open pipe state file!" << endl;
+    }
+    pipeOut << formatPipeState(pipeState);
+}
 
+// run every core that has not halted for up to cycles cycles
+void Pipeline::advance(uint32_t cycles, bool dumpEachCycle) {
+    for (uint32_t count = 0; count < cycles && !halted; count++) {
+        halted = step() == HALT;
+        if (dumpEachCycle) writePipeState();
+    }
+    if (dumpEachCycle) pipeOut.flush();
 }
 
-// run till halt (call runCycles() with cycles == 1 each time) until
-// status tells you to HALT or ERROR out
-Status runTillHalt() {
+bool CycleSimulator::State::allHalted() {
+    for (Pipeline* pipeline : cores) {
+        if (!pipeline->halted) return false;
+    }
+    return true;
+}
+
+// Cycles left until the next barrier. Barriers fall on multiples of the quantum however
+// the run is split into runCycles() calls, which keeps parallel runs deterministic.
+uint32_t CycleSimulator::State::quantumRemaining() {
+    return quantum - globalCycle % quantum;
+}
+
+// Advance every core by length cycles: in lockstep, one cycle per core in core order, or in
+// parallel up to the next barrier.
+void CycleSimulator::State::runQuantum(uint32_t length, bool dumpEachCycle) {
+    if (coreThreads.empty()) {
+        for (uint32_t count = 0; count < length; count++) {
+            for (Pipeline* pipeline : cores) pipeline->advance(1, dumpEachCycle);
+        }
+    } else {
+        quantumLength = length;
+        quantumDump = dumpEachCycle;
+        barrier->wait();  // start the quantum
+        barrier->wait();  // every core is done
+        for (Pipeline* pipeline : cores) pipeline->overlay->commit();
+        coherenceBus->drain();
+        for (Pipeline* pipeline : cores) pipeline->chargeCoherence();
+    }
+    globalCycle += length;
+}
+
+// Every core that has not halted yet advances one cycle per cycle; HALT once all cores have
+// halted.
+Status CycleSimulator::State::runCycles(uint32_t cycles) {
+    if (cores.size() == 1) return cores[0]->runCycles(cycles);
+
+    std::vector<bool> running(cores.size());
+    for (size_t core = 0; core < cores.size(); core++) running[core] = !cores[core]->halted;
+    uint32_t count = 0;
+    while (!allHalted() && (cycles == 0 || count < cycles)) {
+        uint32_t length = quantum ? quantumRemaining() : 1;
+        if (cycles) length = std::min(length, cycles - count);
+        runQuantum(length, false);
+        count += length;
+    }
+    for (size_t core = 0; core < cores.size(); core++) {
+        if (!running[core]) continue;
+        cores[core]->writePipeState();
+        cores[core]->pipeOut.flush();
+    }
+    return allHalted() ? HALT : SUCCESS;
+}
+
+Status CycleSimulator::State::runTillHalt() {
+    // Parallel cores go a whole quantum between barriers, dumping their pipe state each cycle
+    if (!coreThreads.empty()) {
+        while (!allHalted()) runQuantum(quantumRemaining(), true);
+        return HALT;
+    }
+    // A single core only flushes its pipe state once it halted
+    if (cores.size() == 1) {
+        while (cores[0]->runCycles(1, false) != HALT) {
+        }
+        cores[0]->pipeOut.flush();
+        return HALT;
+    }
     Status status;
     while (true) {
         status = static_cast<Status>(runCycles(1));
@@ -584,11 +1187,242 @@ Status runTillHalt() {
     return status;
 }
 
-// dump the state of the emulator
-Status finalizeSimulator() {
-    emulator->dumpRegMem(output);
-    SimulationStats stats{ emulator->getDin(), cycleCount, iCache->getHits(), iCache->getMisses(),
+SimulationStats Pipeline::getStats() {
+    uint32_t din = traceReader ? traceReader->getCount() : emulator->getDin();
+    SimulationStats stats{ din, cycleCount, iCache->getHits(), iCache->getMisses(),
                                                         dCache->getHits(), dCache->getMisses(), loadStalls};  // TODO: Incomplete Implementation
+    stats.hasMissClasses = simOptions.classifyMisses;
+    stats.icMissClasses = iCache->getMissClasses();
+    stats.dcMissClasses = dCache->getMissClasses();
+    stats.hasTlbStats = iTlb || dTlb;
+    if (iTlb) {
+        stats.itlbHits = iTlb->getHits();
+        stats.itlbMisses = iTlb->getMisses();
+    }
+    if (dTlb) {
+        stats.dtlbHits = dTlb->getHits();
+        stats.dtlbMisses = dTlb->getMisses();
+    }
+    stats.hasDramStats = dram != nullptr;
+    if (dram) stats.dram = dram->getStats();
+    stats.hasBusStats = bus != nullptr;
+    if (bus) stats.bus = bus->getStats();
+    stats.hasStoreBufferStats = storeBuffer != nullptr;
+    if (storeBuffer) stats.storeBuffer = storeBuffer->getStats();
+    stats.hasMulDivStats = mulDivOps > 0;
+    stats.mulDivOps = mulDivOps;
+    stats.mulDivStalls = mulDivStalls;
+    return stats;
+}
+
+// dump the state of one core
+Status Pipeline::finalize() {
+    joinProducer();
+    if (!simOptions.fileOutput) return SUCCESS;
+    pipeOut.flush();
+    if (!traceReader) {
+        emulator->dumpRegMem(output, simOptions.memRangeFile);
+    }
+    SimulationStats stats = getStats();
     dumpSimStats(stats, output);
+    if (intervals) {
+        intervals->finish(intervalCounters());
+    }
+    if (simOptions.cpiStack) {
+        cpiStack->dump(output, stats.dynamicInstructions);
+    }
+    if (simOptions.setStats) {
+        iCache->dump(output + "_icache");
+        dCache->dump(output + "_dcache");
+    }
+    if (reuse) {
+        reuse->dump(output);
+    }
+    return SUCCESS;
+}
+
+void CycleSimulator::State::stopThreads() {
+    if (coreThreads.empty()) return;
+    stopCoreThreads = true;
+    barrier->wait();
+    for (std::thread& thread : coreThreads) thread.join();
+    coreThreads.clear();
+}
+
+Status CycleSimulator::State::finalize() {
+    stopThreads();
+    for (Pipeline* pipeline : cores) {
+        pipeline->finalize();
+    }
+    if (coherenceBus && cores[0]->simOptions.fileOutput) {
+        coherenceBus->dump(baseOutput);
+    }
     return SUCCESS;
 }
+
+CycleSimulator::State::~State() {
+    stopThreads();
+    // The cores share memory, the first one deletes it
+    for (size_t core = 1; core < cores.size(); core++) cores[core]->emulator->setMemory(nullptr);
+    for (Pipeline* pipeline : cores) delete pipeline;
+    delete coherenceBus;
+    delete barrier;
+}
+
+CycleSimulator::CycleSimulator() : state(new State()) {}
+
+CycleSimulator::~CycleSimulator() {}
+
+Status CycleSimulator::init(CacheConfig& icConfig, CacheConfig& dcConfig, MemoryStore* memory,
+                            const std::string& output_name, const SimOptions& options) {
+    return state->init(icConfig, dcConfig, memory, output_name, options);
+}
+
+Status CycleSimulator::runCycles(uint32_t cycles) { return state->runCycles(cycles); }
+
+Status CycleSimulator::runTillHalt() { return state->runTillHalt(); }
+
+Status CycleSimulator::finalize() { return state->finalize(); }
+
+SimulationStats CycleSimulator::getStats(uint32_t core) {
+    return state->cores.at(core)->getStats();
+}
+
+PipeState CycleSimulator::getPipeState(uint32_t core) { return state->cores.at(core)->pipeState; }
+
+uint32_t CycleSimulator::getReg(uint32_t core, uint32_t idx) {
+    return state->cores.at(core)->emulator->getReg(idx);
+}
+
+uint32_t CycleSimulator::getPC(uint32_t core) { return state->cores.at(core)->emulator->getPC(); }
+
+MemoryStore* CycleSimulator::getMemory() { return state->cores.at(0)->emulator->getMemory(); }
+
+bool parseSimOption(const std::vector<std::string>& args, size_t& i, SimOptions& options) {
+    const std::string& flag = args[i];
+    bool hasValue = i + 1 < args.size();
+    if (flag == "--decoupled") {
+        options.decoupled = true;
+    } else if (flag == "--replay" && hasValue) {
+        options.replayFile = args[++i];
+    } else if (flag == "--miss-classes") {
+        options.classifyMisses = true;
+    } else if (flag == "--cpi-stack") {
+        options.cpiStack = true;
+    } else if ((flag == "--interval" || flag == "--interval-instrs") && hasValue) {
+        char* end;
+        options.interval = std::strtoull(args[++i].c_str(), &end, 10);
+        options.intervalInstructions = flag == "--interval-instrs";
+        if (*end != '\0' || options.interval == 0) {
+            cerr << LOG_ERROR << "Invalid interval: " << args[i] << endl;
+            return false;
+        }
+    } else if (flag == "--interval-jsonl") {
+        options.intervalFormat = INTERVAL_JSONL;
+    } else if (flag == "--set-stats") {
+        options.setStats = true;
+    } else if (flag == "--reuse") {
+        options.reuse = true;
+    } else if (flag == "--cores" && hasValue) {
+        char* end;
+        unsigned long cores = std::strtoul(args[++i].c_str(), &end, 10);
+        options.cores = cores;
+        if (*end != '\0' || cores == 0 || cores > MAX_CORES) {
+            cerr << LOG_ERROR << "Invalid core count: " << args[i] << endl;
+            return false;
+        }
+    } else if (flag == "--msi") {
+        options.protocol = PROTOCOL_MSI;
+    } else if (flag == "--quantum" && hasValue) {
+        char* end;
+        unsigned long quantum = std::strtoul(args[++i].c_str(), &end, 10);
+        options.quantum = quantum;
+        if (*end != '\0' || quantum == 0 || quantum > UINT32_MAX) {
+            cerr << LOG_ERROR << "Invalid quantum: " << args[i] << endl;
+            return false;
+        }
+    } else if ((flag == "--itlb" || flag == "--dtlb") && hasValue) {
+        TlbConfig& tlb = flag == "--itlb" ? options.iTlb : options.dTlb;
+        if (!parseTlbConfig(args[++i], tlb)) {
+            cerr << LOG_ERROR << "Invalid TLB geometry: " << args[i] << endl;
+            return false;
+        }
+    } else if (flag == "--walk-latency" && hasValue) {
+        char* end;
+        unsigned long latency = std::strtoul(args[++i].c_str(), &end, 10);
+        options.walkLatency = latency;
+        if (*end != '\0' || latency > UINT16_MAX) {
+            cerr << LOG_ERROR << "Invalid walk latency: " << args[i] << endl;
+            return false;
+        }
+    } else if (flag == "--dram" && hasValue) {
+        try {
+            options.dramConfig = readDramConfig(args[++i]);
+            options.dram = true;
+        } catch (const std::invalid_argument& e) {
+            cerr << LOG_ERROR << e.what() << endl;
+            return false;
+        }
+    } else if (flag == "--bus" && hasValue) {
+        char* end;
+        unsigned long bytes = std::strtoul(args[++i].c_str(), &end, 10);
+        options.busBytesPerCycle = bytes;
+        if (*end != '\0' || bytes == 0 || bytes > UINT16_MAX) {
+            cerr << LOG_ERROR << "Invalid bus width: " << args[i] << endl;
+            return false;
+        }
+    } else if (flag == "--bus-policy" && hasValue) {
+        if (!parseBusPolicy(args[++i], options.busPolicy)) {
+            cerr << LOG_ERROR << "Invalid bus policy: " << args[i] << endl;
+            return false;
+        }
+    } else if (flag == "--store-buffer" && hasValue) {
+        char* end;
+        unsigned long depth = std::strtoul(args[++i].c_str(), &end, 10);
+        options.storeBufferDepth = depth;
+        if (*end != '\0' || depth == 0 || depth > UINT16_MAX) {
+            cerr << LOG_ERROR << "Invalid store buffer depth: " << args[i] << endl;
+            return false;
+        }
+    } else if ((flag == "--mult-latency" || flag == "--div-latency") && hasValue) {
+        char* end;
+        unsigned long latency = std::strtoul(args[++i].c_str(), &end, 10);
+        (flag == "--mult-latency" ? options.multLatency : options.divLatency) = latency;
+        if (*end != '\0' || latency == 0 || latency > UINT16_MAX) {
+            cerr << LOG_ERROR << "Invalid " << flag.substr(2) << ": " << args[i] << endl;
+            return false;
+        }
+    } else if (flag == "--mem-range" && hasValue) {
+        options.memRangeFile = args[++i];
+    } else {
+        cerr << LOG_ERROR << "Unknown option: " << flag << endl;
+        return false;
+    }
+    return true;
+}
+
+// The free functions drive one simulator for the whole process
+static CycleSimulator* simulator = nullptr;
+
+// initialize the emulator
+Status initSimulator(CacheConfig& iCacheConfig, CacheConfig& dCacheConfig, MemoryStore* mem,
+                    const std::string& output_name, const SimOptions& options) {
+    simulator = new CycleSimulator();
+    return simulator->init(iCacheConfig, dCacheConfig, mem, output_name, options);
+}
+
+// run the emulator for a certain number of cycles
+Status runCycles(uint32_t cycles) {
+    return simulator->runCycles(cycles);
+}
+
+// run till halt (call runCycles() with cycles == 1 each time) until
+// status tells you to HALT or ERROR out
+Status runTillHalt() {
+    return simulator->runTillHalt();
+}
+
+// dump the state of the emulator
+Status finalizeSimulator() {
+    return simulator->finalize();
+}
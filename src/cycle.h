@@ -1,13 +1,128 @@
 #pragma once
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "Coherence.h"
+#include "Dram.h"
 #include "cache.h"
+#include "IntervalStats.h"
+#include "MemoryBus.h"
+#include "Tlb.h"
 #include "Utilities.h"
 #include "emulator.h"
 
+// Upper bound for SimOptions::cores
+static const uint32_t MAX_CORES = 64;
+// In a multi-core run every core starts with its index in $k0 and the core count in $k1
+static const uint32_t REG_CORE_ID = 26;
+static const uint32_t REG_CORE_COUNT = 27;
+// Cycles the multiply/divide unit is busy with a mult(u) or div(u), see SimOptions
+static const uint32_t MULT_DEFAULT_LATENCY = 4;
+static const uint32_t DIV_DEFAULT_LATENCY = 32;
+
+// Optional simulator features, all off by default
+struct SimOptions {
+    // Run the Emulator ahead on a producer thread and feed the pipeline model through a
+    // lock-free queue. Intended for run-to-halt simulations: stopping early leaves the
+    // architectural state ahead of the last fetched instruction.
+    bool decoupled = false;
+    // Replay instructions from a trace recorded by sim_funct instead of running the Emulator.
+    // Only pipe state and sim stats are produced, there is no register or memory state.
+    std::string replayFile;
+    // Classify cache misses as compulsory, capacity or conflict and add them to the sim stats.
+    bool classifyMisses = false;
+    // Attribute every cycle to a stall cause and write a CPI stack and per-PC stall report.
+    bool cpiStack = false;
+    // Write IPC, cache and stall-cause deltas every `interval` cycles (or retired
+    // instructions if intervalInstructions) to <base>_intervals.csv or .jsonl. 0 disables.
+    uint64_t interval = 0;
+    bool intervalInstructions = false;
+    IntervalFormat intervalFormat = INTERVAL_CSV;
+    // Count accesses, misses and evictions per cache set and dump both caches at the end to
+    // <base>_icache_* and <base>_dcache_* (see CacheModel::dump())
+    bool setStats = false;
+    // Collect reuse-distance histograms and working sets of the cache access streams, at
+    // the configured block sizes, and write <base>_reuse.out
+    bool reuse = false;
+    // Number of cores. Each runs the program on its own pipeline with private caches, sharing
+    // memory, and the data caches are kept coherent with `protocol`. Outputs of core i go to
+    // <base>_core<i>_*, bus counters to <base>_coherence.out. Not with decoupled or replay.
+    uint32_t cores = 1;
+    CoherenceProtocol protocol = PROTOCOL_MESI;
+    // With more than one core, run each core on its own host thread and synchronize every
+    // `quantum` cycles. Stores and coherence requests become visible to the other cores at
+    // the next barrier, so larger quanta are faster but less accurate. A quantum of 1 times
+    // the caches as lockstep does, though misses found at a barrier take the fixed miss
+    // latency. Results only depend on the quantum, not on thread timing. 0 steps the cores
+    // in lockstep on one thread.
+    uint32_t quantum = 0;
+    // Address range of the memory dump, read at the end of the run. Empty for the default.
+    std::string memRangeFile = "print_mem_range";
+    // Split I-TLB and D-TLB in front of the caches, off unless given entries. Each miss adds
+    // a page walk of MMU_WALK_LEVELS * walkLatency cycles to the cache access, and the TLB
+    // hits and misses are added to the sim stats.
+    TlbConfig iTlb;
+    TlbConfig dTlb;
+    uint32_t walkLatency = MMU_DEFAULT_WALK_LATENCY;
+    // Take cache miss latencies from a DRAM model instead of CacheConfig::missLatency. Misses
+    // then cost more or less depending on row buffer locality. Each core has its own channel.
+    bool dram = false;
+    DramConfig dramConfig;
+    // Move every miss's block over a memory bus of this many bytes per cycle, shared by the
+    // I- and D-cache, so misses in the same cycle queue in busPolicy order. 0: no bus, the
+    // caches miss fully in parallel.
+    uint32_t busBytesPerCycle = 0;
+    BusPolicy busPolicy = BUS_ROUND_ROBIN;
+    // Buffer up to this many stores and write them to the D-cache in the background, so only
+    // a store that finds the buffer full stalls MEM. Loads covered by a buffered store skip
+    // the cache. 0 disables. Not with dram or busBytesPerCycle.
+    uint32_t storeBufferDepth = 0;
+    // The multiply/divide unit is not pipelined: a mult(u) or div(u) occupies it for this
+    // many cycles from EX. The next mult/div and any mfhi/mflo wait in ID until it is free.
+    uint32_t multLatency = MULT_DEFAULT_LATENCY;
+    uint32_t divLatency = DIV_DEFAULT_LATENCY;
+    // Write the pipe state and the end-of-run dumps. Without it nothing is written, results
+    // are read through CycleSimulator instead (see MipsSim.h). Not with interval.
+    bool fileOutput = true;
+};
+
+// Parses the option at args[i] into options, advancing i past its value if it takes one.
+// Returns false and reports the error for unknown or invalid options.
+bool parseSimOption(const std::vector<std::string>& args, size_t& i, SimOptions& options);
+
+// One cycle-level simulation: its cores, caches and output files. Independent instances can
+// run concurrently on different threads, as long as their outputs go to different files.
+class CycleSimulator {
+   private:
+    struct State;
+    std::unique_ptr<State> state;
+
+   public:
+    CycleSimulator();
+    ~CycleSimulator();
+
+    // The simulator takes ownership of memory, also when it fails to start
+    Status init(CacheConfig& icConfig, CacheConfig& dcConfig, MemoryStore* memory,
+                const std::string& output_name, const SimOptions& options = SimOptions());
+    Status runCycles(uint32_t cycles);
+    Status runTillHalt();
+    Status finalize();
+    // Statistics of one core so far
+    SimulationStats getStats(uint32_t core = 0);
+    // Architectural state between runs. In decoupled mode the registers run ahead of the
+    // pipeline.
+    PipeState getPipeState(uint32_t core = 0);
+    uint32_t getReg(uint32_t core, uint32_t idx);
+    uint32_t getPC(uint32_t core = 0);
+    MemoryStore* getMemory();
+};
+
+// The functions below drive a single CycleSimulator for the whole process
+
 // init the emulator and all info
 Status initSimulator(CacheConfig& icConfig, CacheConfig& dcConfig, MemoryStore* memory,
-                     const std::string& output_name);
+                     const std::string& output_name, const SimOptions& options = SimOptions());
 
 // run the emulator for a certain number of cycles
 Status runCycles(uint32_t cycles);
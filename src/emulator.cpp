@@ -13,10 +13,13 @@ using namespace std;
 Emulator::Emulator() {
     // Initialize member variables
     memory = nullptr;
+    overlay = nullptr;
     PC = 0;
     encounteredBranch = false;
     savedBranch = 0;
     regData.reg = {};
+    hi = 0;
+    lo = 0;
     din = 0;
 }
 
@@ -39,24 +42,77 @@ uint32_t Emulator::signExt(uint16_t smol) {
     return (smol & 0x8000) ? x ^ extension : x;
 }
 
+// fill the decoded bitfields of info from a raw instruction. nextPC is the PC after the
+// update at fetch, it provides the upper bits of the jump address.
+void Emulator::decode(uint32_t instruction, uint32_t nextPC, InstructionInfo& info) {
+    info.opcode = (instruction >> 26) & 0x3f;
+    info.rs = (instruction >> 21) & 0x1f;
+    info.rt = (instruction >> 16) & 0x1f;
+    info.rd = (instruction >> 11) & 0x1f;
+    info.shamt = (instruction >> 6) & 0x1f;
+    info.funct = instruction & 0x3f;
+    info.immediate = instruction & 0xffff;
+    info.address = instruction & 0x3ffffff;
+    info.signExtImm = (int16_t)info.immediate;
+    info.zeroExtImm = info.immediate;
+    info.branchAddr = info.signExtImm << 2;
+    info.jumpAddr = (nextPC & 0xf0000000) ^ (info.address << 2);
+}
+
 // dump registers and memory
-void Emulator::dumpRegMem(const std::string& output_name) {
+void Emulator::dumpRegMem(const std::string& output_name, const std::string& rangeFile) {
     assert(memory);
     dumpRegisterState(regData.reg, output_name);
-    dumpMemoryState(memory, output_name);
+    dumpMemoryState(memory, output_name, rangeFile);
+}
+
+inline int Emulator::loadMem(uint32_t address, uint32_t& value, MemEntrySize size) {
+    return overlay ? overlay->getMemValue(address, value, size)
+                   : memory->getMemValue(address, value, size);
+}
+
+inline int Emulator::storeMem(uint32_t address, uint32_t value, MemEntrySize size) {
+    return overlay ? overlay->setMemValue(address, value, size)
+                   : memory->setMemValue(address, value, size);
 }
 
 Emulator::InstructionInfo Emulator::executeInstruction() {
-    assert(memory);
     InstructionInfo info;  // information struct for this instruction
-    info.pc = PC;          // fill PC before its updated
+    execute<true>(&info);
+    return info;  // return the InstructionInfo struct of the instruction just executed
+}
+
+Emulator::StepResult Emulator::executeFast() {
+    return execute<false>(nullptr);
+}
+
+Emulator::StepResult Emulator::step(uint32_t n) {
+    StepResult result;
+    for (uint32_t i = 0; n == 0 || i < n; i++) {
+        StepResult cur = executeFast();
+        result.isHalt = cur.isHalt;
+        result.isBranchTaken = cur.isBranchTaken;
+        result.isException = result.isException || cur.isException;
+        if (cur.isHalt) break;
+    }
+    return result;
+}
+
+// Functionally execute one instruction. info is only filled when fillInfo is set, the lean
+// path passes nullptr and only gets the returned StepResult.
+template <bool fillInfo>
+Emulator::StepResult Emulator::execute(InstructionInfo* info) {
+    StepResult result;
+    bool overflow = false;
+    assert(memory);
+    if (fillInfo) info->pc = PC;  // fill PC before its updated
 
     uint32_t instruction;
-    memory->getMemValue(PC, instruction, WORD_SIZE);
-    info.instruction = instruction;
+    loadMem(PC, instruction, WORD_SIZE);
+    if (fillInfo) info->instruction = instruction;
 
     // increment PC & reset zero register
-    info.nextPC = (encounteredBranch) ? savedBranch : PC + 4;
+    if (fillInfo) info->nextPC = (encounteredBranch) ? savedBranch : PC + 4;
     if (!encounteredBranch)
         PC += 4;
     else {
@@ -65,13 +121,14 @@ Emulator::InstructionInfo Emulator::executeInstruction() {
     }
     regData.registers[0] = 0;
 
-    info.instructionID = din;
+    if (fillInfo) info->instructionID = din;
     din += 1;
 
     // check for halt instruction and return immediately
-    info.isHalt = (instruction == 0xfeedfeed);
     if (instruction == 0xfeedfeed) {
-        return info;
+        if (fillInfo) info->isHalt = true;
+        result.isHalt = true;
+        return result;
     }
 
     // parse instruction by completing function calls to extractBits() and set operands accordingly
@@ -91,18 +148,7 @@ Emulator::InstructionInfo Emulator::executeInstruction() {
     uint32_t jumpAddr = (PC & 0xf0000000) ^ (address << 2);  // assumes PC += 4 just happened
 
     // fill the bitfields in the instruction info struct
-    info.opcode = opcode;
-    info.rs = rs;
-    info.rt = rt;
-    info.rd = rd;
-    info.shamt = shamt;
-    info.funct = funct;
-    info.immediate = immediate;
-    info.address = address;
-    info.signExtImm = signExtImm;
-    info.zeroExtImm = zeroExtImm;
-    info.branchAddr = branchAddr;
-    info.jumpAddr = jumpAddr;
+    if (fillInfo) decode(instruction, PC, *info);
 
     uint32_t old_rd = 0;
     uint32_t old_rt = 0;
@@ -121,11 +167,11 @@ Emulator::InstructionInfo Emulator::executeInstruction() {
                     sign_rd = (regData.registers[rd] & 0x80000000);
                     sign_rs = (regData.registers[rs] & 0x80000000);
                     sign_rt = (regData.registers[rt] & 0x80000000);
-                    info.isOverflow = (sign_rs && sign_rt && !sign_rd) ||
+                    overflow = (sign_rs && sign_rt && !sign_rd) ||
                                       (!sign_rs && !sign_rt && sign_rd);
-                    if (info.isOverflow){
+                    if (overflow) {
                         regData.registers[rd] = old_rd;
-                        info.nextPC = 0x8000;  // exception address
+                        if (fillInfo) info->nextPC = 0x8000;  // exception address
                         PC = 0x8000;
                     }
                     break;
@@ -165,22 +211,61 @@ Emulator::InstructionInfo Emulator::executeInstruction() {
                     sign_rd = (regData.registers[rd] & 0x80000000);
                     sign_rs = (regData.registers[rs] & 0x80000000);
                     sign_rt = (regData.registers[rt] & 0x80000000);
-                    info.isOverflow = (sign_rs && !sign_rt && !sign_rd) ||
+                    overflow = (sign_rs && !sign_rt && !sign_rd) ||
                                       (!sign_rs && sign_rt && sign_rd);
-                    if (info.isOverflow){
+                    if (overflow) {
                         regData.registers[rd] = old_rd;
-                        info.nextPC = 0x8000;  // exception address
+                        if (fillInfo) info->nextPC = 0x8000;  // exception address
                         PC = 0x8000;
                     }
                     break;
                 case FUN_SUBU:
                     regData.registers[rd] = regData.registers[rs] - regData.registers[rt];
                     break;
+                case FUN_MFHI:
+                    regData.registers[rd] = hi;
+                    break;
+                case FUN_MFLO:
+                    regData.registers[rd] = lo;
+                    break;
+                case FUN_MULT: {
+                    int64_t product = int64_t(int32_t(regData.registers[rs])) *
+                                      int32_t(regData.registers[rt]);
+                    hi = uint64_t(product) >> 32;
+                    lo = uint32_t(product);
+                    break;
+                }
+                case FUN_MULTU: {
+                    uint64_t product = uint64_t(regData.registers[rs]) * regData.registers[rt];
+                    hi = product >> 32;
+                    lo = uint32_t(product);
+                    break;
+                }
+                case FUN_DIV: {
+                    // Division by zero leaves HI and LO unchanged (unpredictable on MIPS), and
+                    // so does the INT_MIN / -1 overflow
+                    int32_t dividend = regData.registers[rs];
+                    int32_t divisor = regData.registers[rt];
+                    if (divisor != 0 && !(dividend == INT32_MIN && divisor == -1)) {
+                        lo = dividend / divisor;
+                        hi = dividend % divisor;
+                    }
+                    break;
+                }
+                case FUN_DIVU:
+                    if (regData.registers[rt] != 0) {
+                        lo = regData.registers[rs] / regData.registers[rt];
+                        hi = regData.registers[rs] % regData.registers[rt];
+                    }
+                    break;
                 default:
                     // printf("next PC 0x%08x \n", info.nextPC);
                     std::cerr << LOG_ERROR << "Illegal operation..." << std::endl;
-                    info.isValid = false;
-                    info.nextPC = 0x8000;  // exception address
+                    result.isException = true;
+                    if (fillInfo) {
+                        info->isValid = false;
+                        info->nextPC = 0x8000;  // exception address
+                    }
                     PC = 0x8000;
             }
             break;
@@ -192,11 +277,11 @@ Emulator::InstructionInfo Emulator::executeInstruction() {
             sign_rt = (regData.registers[rt] & 0x80000000);
             sign_rs = (regData.registers[rs] & 0x80000000);
             sign_imm = (signExtImm & 0x80000000);
-            info.isOverflow = (sign_rs && sign_imm && !sign_rt) ||
+            overflow = (sign_rs && sign_imm && !sign_rt) ||
                               (!sign_rs && !sign_imm && sign_rt);
-            if (info.isOverflow){
+            if (overflow) {
                 regData.registers[rt] = old_rt;
-                info.nextPC = 0x8000;  // exception address
+                if (fillInfo) info->nextPC = 0x8000;  // exception address
                 PC = 0x8000;
             }
             // exit(1);
@@ -241,22 +326,19 @@ Emulator::InstructionInfo Emulator::executeInstruction() {
             savedBranch = jumpAddr;
             break;
         case OP_LBU:
-            info.loadAddress = regData.registers[rs] + signExtImm;  // capture load address
-            memory->getMemValue(regData.registers[rs] + signExtImm, regData.registers[rt],
-                                BYTE_SIZE);
+            if (fillInfo) info->loadAddress = regData.registers[rs] + signExtImm;  // capture load address
+            loadMem(regData.registers[rs] + signExtImm, regData.registers[rt], BYTE_SIZE);
             break;
         case OP_LHU:
-            info.loadAddress = regData.registers[rs] + signExtImm;  // capture load address
-            memory->getMemValue(regData.registers[rs] + signExtImm, regData.registers[rt],
-                                HALF_SIZE);
+            if (fillInfo) info->loadAddress = regData.registers[rs] + signExtImm;  // capture load address
+            loadMem(regData.registers[rs] + signExtImm, regData.registers[rt], HALF_SIZE);
             break;
         case OP_LUI:
             regData.registers[rt] = zeroExtImm << 16;
             break;
         case OP_LW:
-            info.loadAddress = regData.registers[rs] + signExtImm;  // capture load address
-            memory->getMemValue(regData.registers[rs] + signExtImm, regData.registers[rt],
-                                WORD_SIZE);
+            if (fillInfo) info->loadAddress = regData.registers[rs] + signExtImm;  // capture load address
+            loadMem(regData.registers[rs] + signExtImm, regData.registers[rt], WORD_SIZE);
             break;
         case OP_ORI:
             regData.registers[rt] = regData.registers[rs] | zeroExtImm;
@@ -268,26 +350,34 @@ Emulator::InstructionInfo Emulator::executeInstruction() {
             regData.registers[rt] = (regData.registers[rs] < uint32_t(signExtImm)) ? 1 : 0;
             break;
         case OP_SB:
-            info.storeAddress = regData.registers[rs] + signExtImm;  // capture store address
-            memory->setMemValue(regData.registers[rs] + signExtImm,
-                                extractBits(regData.registers[rt], 7, 0), BYTE_SIZE);
+            if (fillInfo) info->storeAddress = regData.registers[rs] + signExtImm;  // capture store address
+            storeMem(regData.registers[rs] + signExtImm, extractBits(regData.registers[rt], 7, 0),
+                     BYTE_SIZE);
             break;
         case OP_SH:
-            info.storeAddress = regData.registers[rs] + signExtImm;  // capture store address
-            memory->setMemValue(regData.registers[rs] + signExtImm,
-                                extractBits(regData.registers[rt], 15, 0), HALF_SIZE);
+            if (fillInfo) info->storeAddress = regData.registers[rs] + signExtImm;  // capture store address
+            storeMem(regData.registers[rs] + signExtImm, extractBits(regData.registers[rt], 15, 0),
+                     HALF_SIZE);
             break;
         case OP_SW:
-            info.storeAddress = regData.registers[rs] + signExtImm;  // capture store address
-            memory->setMemValue(regData.registers[rs] + signExtImm, regData.registers[rt],
-                                WORD_SIZE);
+            if (fillInfo) info->storeAddress = regData.registers[rs] + signExtImm;  // capture store address
+            storeMem(regData.registers[rs] + signExtImm, regData.registers[rt], WORD_SIZE);
             break;
         default:
             std::cerr << LOG_ERROR << "Illegal operation..." << std::endl;
-            info.isValid = false;
-            info.nextPC = 0x8000;  // exception address
+            result.isException = true;
+            if (fillInfo) {
+                info->isValid = false;
+                info->nextPC = 0x8000;  // exception address
+            }
             PC = 0x8000;
     }
     // printf("next PC 0x%08x \n", info.nextPC);
-    return info;  // return the InstructionInfo struct of the instruction just executed
+    if (fillInfo) {
+        info->isOverflow = overflow;
+        info->isBranchTaken = encounteredBranch;  // only set by this instruction
+    }
+    result.isException = result.isException || overflow;
+    result.isBranchTaken = encounteredBranch;
+    return result;
 }
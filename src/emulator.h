@@ -45,9 +45,20 @@ enum FUNCT_IDS {
     FUN_SLL  = 0x00,   // shift left logical (sll)
     FUN_SRL  = 0x02,   // shift right logical (srl)
     FUN_SUB  = 0x22,   // substract (sub)
-    FUN_SUBU = 0x23    // substract unsigned (subu)
+    FUN_SUBU = 0x23,   // substract unsigned (subu)
+    FUN_MFHI = 0x10,   // move from HI (mfhi)
+    FUN_MFLO = 0x12,   // move from LO (mflo)
+    FUN_MULT = 0x18,   // multiply (mult)
+    FUN_MULTU = 0x19,  // multiply unsigned (multu)
+    FUN_DIV  = 0x1a,   // divide (div)
+    FUN_DIVU = 0x1b    // divide unsigned (divu)
 };
 
+// mult, multu, div and divu: write HI and LO instead of a general register
+inline bool isMulDiv(uint32_t opcode, uint32_t funct) {
+    return opcode == OP_ZERO && funct >= FUN_MULT && funct <= FUN_DIVU;
+}
+
 class Emulator {
    private:
     union REGS {
@@ -57,8 +68,13 @@ class Emulator {
 
     // Registers
     union REGS regData;
+    // Results of the multiply and divide instructions
+    uint32_t hi;
+    uint32_t lo;
     // memory component
     MemoryStore* memory;
+    // if set, all memory accesses go through it instead (parallel multi-core runs)
+    MemoryOverlay* overlay;
 
     // Arch states and statistics
     uint32_t PC;
@@ -82,6 +98,7 @@ struct InstructionInfo {
         bool     isHalt = false;     // is this 0xfeedfeed
         bool     isValid = true;     // is this a valid instruction
         bool     isOverflow = false; // causes overflow
+        bool     isBranchTaken = false; // branch or jump that redirects the PC
         uint32_t instructionID = 0;  // din of the instruction
         uint32_t instruction = 0;    // raw instruction
         uint32_t opcode = 0;         // bit-fields for this instruction
@@ -100,16 +117,49 @@ struct InstructionInfo {
         uint32_t storeAddress = 0; 
     };
 
+    // Result of the lean execute path: only what is needed to keep running.
+    struct StepResult {
+        bool isHalt = false;       // a 0xfeedfeed was executed
+        bool isException = false;  // an overflow or illegal instruction was executed
+        bool isBranchTaken = false;  // a branch or jump that redirects the PC (last one only)
+    };
+
     // getters and setters
     auto getPC() { return PC; }
     auto getDin() { return din; }
     auto getMemory() { return memory; }
+    uint32_t getReg(uint32_t idx) { return regData.registers[idx]; }
+    void setReg(uint32_t idx, uint32_t value) {
+        if (idx != 0) regData.registers[idx] = value;
+    }
+    uint32_t getHi() { return hi; }
+    uint32_t getLo() { return lo; }
 
     void setMemory(MemoryStore* mem) { memory = mem; }
+    void setOverlay(MemoryOverlay* memOverlay) { overlay = memOverlay; }
+
+    // fill the bitfields (opcode .. jumpAddr) of info from a raw instruction word
+    static void decode(uint32_t instruction, uint32_t nextPC, InstructionInfo& info);
 
     // functionally execute one instruction
     InstructionInfo executeInstruction();
 
-    // Helper function to dump registers and memory
-    void dumpRegMem(const std::string& output_name);
+    // functionally execute one instruction without filling an InstructionInfo
+    StepResult executeFast();
+
+    // execute up to n instructions (n == 0 runs until halt) on the lean path, stopping
+    // early at a halt. isException is set if any executed instruction raised one.
+    StepResult step(uint32_t n);
+
+    // Helper function to dump registers and memory, over the range given in rangeFile
+    void dumpRegMem(const std::string& output_name,
+                    const std::string& rangeFile = "print_mem_range");
+
+   private:
+    int loadMem(uint32_t address, uint32_t& value, MemEntrySize size);
+    int storeMem(uint32_t address, uint32_t value, MemEntrySize size);
+
+    // Shared implementation of executeInstruction() and executeFast()
+    template <bool fillInfo>
+    StepResult execute(InstructionInfo* info);
 };
\ No newline at end of file
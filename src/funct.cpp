@@ -1,19 +1,64 @@
 #include "funct.h"
 
+#include <fstream>
 #include <iostream>
+#include <string>
 
+#include "ExecProfile.h"
+#include "InstrTrace.h"
+#include "ReuseDistance.h"
 #include "cache.h"
 #include "Utilities.h"
 #include "emulator.h"
 
 static Emulator* emulator = nullptr;
 static std::string output;
+static TraceWriter* traceWriter = nullptr;
+static std::ofstream addrTrace;
+static std::string addrTraceBuf;
+static ExecProfile* profile = nullptr;
+static ReuseProfiler* reuse = nullptr;
+
+// append the fetch and data addresses of an instruction to the text address trace
+static void writeAddrTrace(const Emulator::InstructionInfo& info) {
+    addrTraceBuf += "I ";
+    appendHex(addrTraceBuf, info.pc, 8);
+    addrTraceBuf += '\n';
+    if (traceHasMemAddress(info)) {
+        addrTraceBuf += traceIsStore(info) ? "W " : "R ";
+        appendHex(addrTraceBuf, info.loadAddress | info.storeAddress, 8);
+        addrTraceBuf += '\n';
+    }
+    if (addrTraceBuf.size() >= TRACE_BUFFER_SIZE) {
+        addrTrace.write(addrTraceBuf.data(), addrTraceBuf.size());
+        addrTraceBuf.clear();
+    }
+}
 
 // initialize the emulator
-Status initEmulator(MemoryStore* mem, const std::string& output_name) {
+Status initEmulator(MemoryStore* mem, const std::string& output_name,
+                    const FunctOptions& options) {
     output = output_name;
     emulator = new Emulator();
     emulator->setMemory(mem);
+    if (options.profile) {
+        profile = new ExecProfile();
+    }
+    if (options.reuse) {
+        reuse = new ReuseProfiler(REUSE_DEFAULT_BLOCK_SIZE, REUSE_DEFAULT_BLOCK_SIZE);
+    }
+    if (!options.traceFile.empty()) {
+        traceWriter = new TraceWriter();
+        if (traceWriter->open(options.traceFile) != SUCCESS) return ERROR;
+    }
+    if (!options.addrTraceFile.empty()) {
+        addrTrace.open(options.addrTraceFile);
+        if (!addrTrace) {
+            std::cerr << LOG_ERROR << "Could not create address trace file "
+                      << options.addrTraceFile << std::endl;
+            return ERROR;
+        }
+    }
     return SUCCESS;
 }
 
@@ -21,11 +66,33 @@ Status initEmulator(MemoryStore* mem, const std::string& output_name) {
 // return SUCCESS if count of executed instructions == desired intructions.
 // return HALT if the simulator halts on 0xfeedfeed
 Status runInstructions(uint32_t instructions) {
+    if (!traceWriter && !addrTrace.is_open() && !reuse) {
+        // Only the halt status is needed here, so use the lean execute path.
+        if (!profile) {
+            Emulator::StepResult result = emulator->step(instructions);
+            return result.isHalt ? HALT : SUCCESS;
+        }
+        for (uint32_t i = 0; instructions == 0 || i < instructions; i++) {
+            uint32_t pc = emulator->getPC();
+            Emulator::StepResult result = emulator->executeFast();
+            profile->record(pc, result.isBranchTaken);
+            if (result.isHalt) return HALT;
+        }
+        return SUCCESS;
+    }
+
     uint32_t numInstructions = 0;
     auto status = SUCCESS;
 
     while (instructions == 0 || numInstructions < instructions) {
         Emulator::InstructionInfo info = emulator->executeInstruction();
+        if (traceWriter) traceWriter->write(info);
+        if (addrTrace.is_open()) writeAddrTrace(info);
+        if (profile) profile->record(info.pc, info.isBranchTaken);
+        if (reuse) {
+            reuse->instruction(info.pc);
+            if (traceHasMemAddress(info)) reuse->data(info.loadAddress | info.storeAddress);
+        }
 
         numInstructions += 1;
 
@@ -37,19 +104,29 @@ Status runInstructions(uint32_t instructions) {
     return status;
 }
 
-// run till halt (call runInstructions() with instructions == 1 each time) until
+// run till halt (a single runInstructions() call with instructions == 0, so the lean path
+// runs the whole program in one loop) until
 // status tells you to HALT or ERROR out
 Status runTillHalt() {
-    Status status;
-    while (true) {
-        status = static_cast<Status>(runInstructions(1));
-        if (status == HALT) break;
-    }
-    return status;
+    return runInstructions(0);
 }
 
 // dump the stats of the emulator
 Status finalizeEmulator() {
+    if (traceWriter) {
+        delete traceWriter;
+        traceWriter = nullptr;
+    }
+    if (addrTrace.is_open()) {
+        addrTrace.write(addrTraceBuf.data(), addrTraceBuf.size());
+        addrTrace.close();
+    }
+    if (profile) {
+        profile->dump(output, emulator->getMemory());
+    }
+    if (reuse) {
+        reuse->dump(output);
+    }
     emulator->dumpRegMem(output);
     SimulationStats stats{emulator->getDin(), 0,};
     dumpSimStats(stats, output);
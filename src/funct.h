@@ -4,13 +4,28 @@
 #include "Utilities.h"
 #include "emulator.h"
 
+// Optional emulator features, all off by default
+struct FunctOptions {
+    // Record every retired instruction to this file for replay by sim_cycle (see InstrTrace.h)
+    std::string traceFile;
+    // Write the instruction fetch and load/store addresses to this file as text, one
+    // "I|R|W <hex address>" line per access, for sim_cachetrace
+    std::string addrTraceFile;
+    // Count executions per static PC and basic block and write <base>_profile.out
+    bool profile = false;
+    // Collect reuse-distance histograms and working sets and write <base>_reuse.out
+    bool reuse = false;
+};
+
 // init the emulator and all info
-Status initEmulator(MemoryStore* memory, const std::string& output_name);
+Status initEmulator(MemoryStore* memory, const std::string& output_name,
+                    const FunctOptions& options = FunctOptions());
 
 // run the emulator for a certain number of instructions
 Status runInstructions(uint32_t instructions);
 
-// run till halt (call runInstructions() with instructions == 1 each time) until
+// run till halt (a single runInstructions() call with instructions == 0, so the lean path
+// runs the whole program in one loop) until
 // status tells you to HALT or ERROR out
 Status runTillHalt();
 
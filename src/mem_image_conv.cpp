@@ -0,0 +1,47 @@
+/** NOTE Memory Image Converter
+ * Converts a text init_mem_image (hex address/word pairs, one pair per line) into the binary
+ * segment format understood by prepareMemory(). Runs of consecutive words are merged into a
+ * single segment so large datasets load with a handful of bulk copies.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include "MemoryStore.h"
+#include "Utilities.h"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        cerr << LOG_ERROR << "Usage: " << argv[0] << " <text_mem_image> <binary_mem_image>"
+             << endl;
+        return ERROR;
+    }
+
+    ifstream in(argv[1]);
+    if (!in) {
+        cerr << LOG_ERROR << "Unable to open text memory image " << argv[1] << endl;
+        return ERROR;
+    }
+
+    ofstream out(argv[2], ios::binary | ios::out);
+    if (!out) {
+        cerr << LOG_ERROR << "Unable to create binary memory image " << argv[2] << endl;
+        return ERROR;
+    }
+
+    uint32_t words = 0;
+    uint32_t segments = 0;
+    if (convertMemImage(in, out, words, segments)) {
+        cerr << LOG_ERROR << "Could not convert " << argv[1] << endl;
+        out.close();
+        remove(argv[2]);
+        return ERROR;
+    }
+
+    cout << "[Converter] Wrote " << dec << words << " words in " << segments << " segments to "
+         << argv[2] << endl;
+    return SUCCESS;
+}
@@ -0,0 +1,114 @@
+/** Batch runner for the cycle-accurate simulator
+ * Runs every job of a manifest on a fixed pool of threads, each job with its own
+ * CycleSimulator and output directory, and appends its results to a CSV or JSON lines file,
+ * one row per core of each job (see Batch.h).
+ *
+ * Manifest: one job per line, `<file.bin> <cache_config.txt> [options]`, where the options
+ * are those of sim_cycle plus `--init-image <file>`. Jobs do not read init_mem_image or
+ * print_mem_range from the current directory, pass --init-image and --mem-range instead.
+ * Blank lines and lines starting with '#' are skipped.
+ */
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Batch.h"
+#include "Utilities.h"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string outDir = "batch_out";
+    for (int i = 3; i < argc; i++) {
+        std::string flag = argv[i];
+        if (flag == "--threads" && i + 1 < argc) {
+            char* end;
+            unsigned long count = std::strtoul(argv[++i], &end, 10);
+            threads = count;
+            if (*end != '\0' || count == 0 || count > 1024) {
+                cerr << LOG_ERROR << "Invalid thread count: " << argv[i] << endl;
+                argc = 0;
+            }
+        } else if (flag == "--out-dir" && i + 1 < argc) {
+            outDir = argv[++i];
+        } else {
+            cerr << LOG_ERROR << "Unknown option: " << flag << endl;
+            argc = 0;  // fall through to the usage message
+        }
+    }
+
+    if (argc < 3) {
+        cerr << LOG_ERROR << "Usage: " << argv[0]
+             << " <manifest> <results.csv|results.jsonl> [options]" << endl
+             << "Each manifest line is `<file.bin> <cache_config.txt> [sim_cycle options]`, "
+                "plus --init-image <file> to load an initial memory image."
+             << endl
+             << "Options:" << endl
+             << "  --threads <n>      run n jobs at a time (default: one per host CPU)" << endl
+             << "  --out-dir <dir>    write the outputs of job i to <dir>/job<i> (default: "
+                "batch_out)"
+             << endl;
+        exit(ERROR);
+    }
+
+    std::vector<BatchJob> jobs;
+    ifstream manifest(argv[1]);
+    if (!manifest) {
+        cerr << LOG_ERROR << "Unable to open manifest " << argv[1] << endl;
+        return ERROR;
+    }
+    if (!readManifest(manifest, argv[1], jobs)) return ERROR;
+    if (!makeDir(outDir)) {
+        cerr << LOG_ERROR << "Unable to create " << outDir << endl;
+        return ERROR;
+    }
+
+    std::string resultsFile = argv[2];
+    bool jsonl = resultsFile.size() >= 6 && resultsFile.substr(resultsFile.size() - 6) == ".jsonl";
+    bool newFile = fileSize(resultsFile) == 0;
+    ofstream results(resultsFile, ios::app);
+    if (!results) {
+        cerr << LOG_ERROR << "Unable to open " << resultsFile << endl;
+        return ERROR;
+    }
+    if (newFile && !jsonl) results << BATCH_CSV_HEADER << flush;
+
+    // Largest first, so a long job started last does not leave the other threads idle
+    std::vector<const BatchJob*> order;
+    for (const BatchJob& job : jobs) order.push_back(&job);
+    std::stable_sort(order.begin(), order.end(), [](const BatchJob* lhs, const BatchJob* rhs) {
+        return lhs->cost > rhs->cost;
+    });
+
+    ImageCache imageCache;
+    std::atomic<size_t> next(0);
+    std::atomic<uint32_t> failed(0);
+    std::mutex resultsMutex;
+    auto worker = [&]() {
+        for (size_t i = next++; i < order.size(); i = next++) {
+            BatchResult result = runJob(*order[i], imageCache, outDir);
+            if (result.status != HALT) failed++;
+            std::string row = formatResult(*order[i], result, jsonl);
+            std::lock_guard<std::mutex> lock(resultsMutex);
+            results << row << flush;
+        }
+    };
+
+    cout << "[Batch] Running " << jobs.size() << " jobs on " << threads << " threads" << endl;
+    std::vector<std::thread> pool;
+    for (uint32_t i = 1; i < std::min<size_t>(threads, order.size()); i++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : pool) thread.join();
+
+    cout << "[Batch] Finished, " << failed << " of " << jobs.size() << " jobs failed" << endl;
+    return failed ? ERROR : SUCCESS;
+}
@@ -0,0 +1,135 @@
+/** NOTE Cache Trace Simulator
+ * Drives the I-cache and D-cache models straight from an address trace, without the pipeline.
+ * Accepts either an instruction trace recorded by `sim_funct --trace` (binary, delta-encoded)
+ * or a text address trace written by `sim_funct --addr-trace`.
+ */
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "InstrTrace.h"
+#include "Utilities.h"
+#include "cache.h"
+
+using namespace std;
+
+// Addresses are handed to the caches in batches of this many.
+static const size_t BATCH_SIZE = 4096;
+
+// Collects the addresses of one stream and runs them through its cache in batches.
+struct CacheStream {
+    unique_ptr<CacheModel> cache;
+    vector<uint32_t> batch;
+    uint64_t accesses = 0;
+
+    explicit CacheStream(const CacheConfig& config, CacheDataType type)
+        : cache(createCache(config, type)) {
+        batch.reserve(BATCH_SIZE);
+    }
+
+    void add(uint32_t address) {
+        batch.push_back(address);
+        if (batch.size() == BATCH_SIZE) flush();
+    }
+
+    void flush() {
+        cache->accessMany(batch.data(), batch.size());
+        accesses += batch.size();
+        batch.clear();
+    }
+};
+
+static Status runInstrTrace(const char* fileName, CacheStream& iStream, CacheStream& dStream) {
+    TraceReader reader;
+    if (reader.open(fileName) != SUCCESS) return ERROR;
+
+    Emulator::InstructionInfo info;
+    while (reader.next(info)) {
+        iStream.add(info.pc);
+        if (traceHasMemAddress(info)) {
+            dStream.add(info.loadAddress | info.storeAddress);
+        }
+    }
+    return SUCCESS;
+}
+
+static Status runTextTrace(const char* fileName, CacheStream& iStream, CacheStream& dStream) {
+    ifstream in(fileName);
+    if (!in) {
+        cerr << LOG_ERROR << "Could not open address trace " << fileName << endl;
+        return ERROR;
+    }
+
+    string kind;
+    uint32_t address;
+    while (in >> kind >> hex >> address) {
+        if (kind == "I") {
+            iStream.add(address);
+        } else if (kind == "R" || kind == "W") {
+            dStream.add(address);
+        } else {
+            cerr << LOG_ERROR << "Unknown access kind " << kind << " in " << fileName << endl;
+            return ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+static void printStats(const char* name, CacheStream& stream) {
+    uint32_t hits = stream.cache->getHits();
+    uint32_t misses = stream.cache->getMisses();
+    double hitRate = stream.accesses ? 100.0 * hits / stream.accesses : 0.0;
+    cout << left << setw(23) << string(name) + " accesses: " << stream.accesses << endl;
+    cout << left << setw(23) << string(name) + " hits: " << hits << endl;
+    cout << left << setw(23) << string(name) + " misses: " << misses << endl;
+    cout << left << setw(23) << string(name) + " hit rate: " << fixed << setprecision(2)
+         << hitRate << "%" << endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        cerr << LOG_ERROR << "Usage: " << argv[0] << " <trace> <cache_config.txt>" << endl;
+        return ERROR;
+    }
+
+    CacheConfig icConfig, dcConfig;
+    try {
+        readCacheConfigs(argv[2], icConfig, dcConfig);
+    } catch (const std::invalid_argument& e) {
+        cerr << LOG_ERROR << e.what() << endl;
+        return ERROR;
+    }
+    cout << LOG_INFO << LOG_VAR(icConfig) << endl;
+    cout << LOG_INFO << LOG_VAR(dcConfig) << endl;
+
+    CacheStream iStream(icConfig, I_CACHE);
+    CacheStream dStream(dcConfig, D_CACHE);
+
+    // Instruction traces are recognised by their magic, anything else is read as text.
+    char magic[TRACE_MAGIC_LEN] = {0};
+    ifstream probe(argv[1], ios::binary);
+    bool isInstrTrace = probe.read(magic, TRACE_MAGIC_LEN) &&
+                        string(magic, TRACE_MAGIC_LEN) == string(TRACE_MAGIC, TRACE_MAGIC_LEN);
+    probe.close();
+
+    auto start = chrono::steady_clock::now();
+    Status status = isInstrTrace ? runInstrTrace(argv[1], iStream, dStream)
+                                 : runTextTrace(argv[1], iStream, dStream);
+    iStream.flush();
+    dStream.flush();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (status != SUCCESS) return status;
+
+    printStats("I-cache", iStream);
+    printStats("D-cache", dStream);
+    uint64_t total = iStream.accesses + dStream.accesses;
+    cout << left << setw(23) << "Accesses per second: " << fixed << setprecision(0)
+         << (seconds > 0 ? total / seconds : 0.0) << endl;
+    return SUCCESS;
+}
@@ -2,11 +2,13 @@
  * This is a sample main function, you can modify main() to test,
  * but we may use a different main() to grade, so do not put any simulation functionality here.
  */
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <tuple>
+#include <vector>
 
 #include "MemoryStore.h"
 #include "Utilities.h"
@@ -15,14 +17,70 @@
 
 using namespace std;
 
-inline std::tuple<std::string, CacheConfig, CacheConfig> parseArgs(int argc, char** argv) {
-    if (argc != 3) {
-        std::cerr << LOG_ERROR << "Usage: " << argv[0] << " <file.bin> <cache_config.txt>"
-                  << std::endl
+inline std::tuple<std::string, CacheConfig, CacheConfig, SimOptions> parseArgs(int argc,
+                                                                                char** argv) {
+    SimOptions options;
+    std::vector<std::string> args(argv, argv + argc);
+    for (size_t i = 3; i < args.size(); i++) {
+        if (!parseSimOption(args, i, options)) {
+            argc = 0;  // fall through to the usage message
+            break;
+        }
+    }
+
+    if (argc < 3) {
+        std::cerr << LOG_ERROR << "Usage: " << argv[0]
+                  << " <file.bin> <cache_config.txt> [options]" << std::endl
                   << "Note:" << std::endl
                   << "The sim_cycle binary should take two command-line arguments indicating the "
                      "name of the binary file to be read and the cache configuration file to be "
                      "used. For more details, refer to the project description document."
+                  << std::endl
+                  << "Options:" << std::endl
+                  << "  --decoupled        run the functional emulator on its own thread"
+                  << std::endl
+                  << "  --replay <trace>   replay a trace recorded by sim_funct --trace"
+                  << std::endl
+                  << "  --miss-classes     report compulsory, capacity and conflict misses"
+                  << std::endl
+                  << "  --cpi-stack        write a CPI stack and per-PC stall report"
+                  << std::endl
+                  << "  --interval <n>     write interval stats every n cycles" << std::endl
+                  << "  --interval-instrs <n>  write interval stats every n retired instructions"
+                  << std::endl
+                  << "  --interval-jsonl   write interval stats as JSON lines instead of CSV"
+                  << std::endl
+                  << "  --set-stats        write per-set heatmaps and eviction counts of both caches"
+                  << std::endl
+                  << "  --reuse            write reuse-distance histograms and working sets"
+                  << std::endl
+                  << "  --cores <n>        run n cores with MESI-coherent private data caches"
+                  << std::endl
+                  << "  --msi              keep the data caches coherent with MSI instead of MESI"
+                  << std::endl
+                  << "  --quantum <n>      run each core on its own thread, synchronizing every n "
+                     "cycles"
+                  << std::endl
+                  << "  --itlb <n>[:<ways>] model an I-TLB of n entries, fully associative by "
+                     "default"
+                  << std::endl
+                  << "  --dtlb <n>[:<ways>] model a D-TLB of n entries" << std::endl
+                  << "  --walk-latency <n> cycles per page-table level on a TLB miss (default 10)"
+                  << std::endl
+                  << "  --dram <config>    take miss latencies from a DRAM model (see "
+                     "test/dram_config.txt)"
+                  << std::endl
+                  << "  --bus <n>          share an n bytes per cycle memory bus between the "
+                     "cache misses"
+                  << std::endl
+                  << "  --bus-policy <p>   bus arbitration: ifetch, data or rr (default)"
+                  << std::endl
+                  << "  --store-buffer <n> buffer up to n stores and forward them to loads"
+                  << std::endl
+                  << "  --mult-latency <n> cycles of a mult or multu (default 4)" << std::endl
+                  << "  --div-latency <n>  cycles of a div or divu (default 32)" << std::endl
+                  << "  --mem-range <file> read the memory dump range from file instead of "
+                     "print_mem_range"
                   << std::endl;
         exit(ERROR);
     }
@@ -31,38 +89,13 @@ inline std::tuple<std::string, CacheConfig, CacheConfig> parseArgs(int argc, cha
         std::string inputFile = argv[1];
         std::string cacheFile = argv[2];
 
-        std::ifstream file(cacheFile);
-        if (!file.is_open()) {
-            std::cerr << LOG_ERROR << "Failed to open cache config file: " << cacheFile
-                      << std::endl;
-            exit(ERROR);
-        }
-
-        int line = 0;
-        auto parseNextLine = [&](const char* name) -> uint32_t {
-            line++;
-            uint32_t value;
-            if (!(file >> value)) {
-                std::stringstream errorMessage;
-                errorMessage << "Failed to parse property at line " << line << " for property "
-                             << name;
-                throw std::invalid_argument(errorMessage.str());
-            }
-            std::string discard;
-            std::getline(file, discard);  // discard rest of the line
-            return value;
-        };
-
-        CacheConfig icConfig{parseNextLine("ICache cache size"), parseNextLine("ICache block size"),
-                             parseNextLine("ICache ways"), parseNextLine("ICache miss latency")};
-
-        CacheConfig dcConfig{parseNextLine("DCache cache size"), parseNextLine("DCache block size"),
-                             parseNextLine("DCache ways"), parseNextLine("DCache miss latency")};
+        CacheConfig icConfig, dcConfig;
+        readCacheConfigs(cacheFile, icConfig, dcConfig);
 
         std::cout << LOG_INFO << LOG_VAR(icConfig) << std::endl;
         std::cout << LOG_INFO << LOG_VAR(dcConfig) << std::endl;
 
-        return std::make_tuple(inputFile, icConfig, dcConfig);
+        return std::make_tuple(inputFile, icConfig, dcConfig, options);
 
     } catch (const std::invalid_argument& e) {
         std::cerr << LOG_ERROR << e.what() << std::endl;
@@ -78,11 +111,14 @@ int main(int argc, char** argv) {
     auto inputFile = std::get<0>(simArgs);
     auto iCacheConfig = std::get<1>(simArgs);
     auto dCacheConfig = std::get<2>(simArgs);
+    auto options = std::get<3>(simArgs);
 
     cout << "[Simulator] Loading memory from " << LOG_VAR(inputFile) << endl;
     auto baseFilename = getBaseFilename(argv[1]) + "_cycle";
-    initSimulator(iCacheConfig, dCacheConfig, new MemoryStore(0, MEMORY_SIZE, argv[1]),
-                  baseFilename);
+    if (initSimulator(iCacheConfig, dCacheConfig, new MemoryStore(0, MEMORY_SIZE, argv[1]),
+                      baseFilename, options) != SUCCESS) {
+        return ERROR;
+    }
 
     cout << "[Simulator] Start simulator" << endl;
     auto status = runTillHalt();
@@ -12,14 +12,39 @@
 using namespace std;
 
 int main(int argc, char** argv) {
+    FunctOptions options;
+    for (int i = 2; i < argc; i++) {
+        string flag = argv[i];
+        if (flag == "--trace" && i + 1 < argc) {
+            options.traceFile = argv[++i];
+        } else if (flag == "--addr-trace" && i + 1 < argc) {
+            options.addrTraceFile = argv[++i];
+        } else if (flag == "--profile") {
+            options.profile = true;
+        } else if (flag == "--reuse") {
+            options.reuse = true;
+        } else {
+            cerr << LOG_ERROR << "Unknown option: " << flag << endl;
+            argc = 0;  // fall through to the usage message
+        }
+    }
+
     if (argc < 2) {
-        cerr << LOG_ERROR << "Usage: " << argv[0] << " <input_file>" << endl;
+        cerr << LOG_ERROR << "Usage: " << argv[0] << " <input_file> [options]" << endl
+             << "Options:" << endl
+             << "  --trace <file>       record retired instructions for sim_cycle --replay" << endl
+             << "  --addr-trace <file>  write a text address trace for sim_cachetrace" << endl
+             << "  --profile            write a basic-block and hot-PC execution profile" << endl
+             << "  --reuse              write reuse-distance histograms and working sets" << endl;
         return ERROR;
     }
 
     cout << "[Simulator] Loading memory from " << LOG_VAR(argv[1]) << endl;
     auto baseFilename = getBaseFilename(argv[1]) + "_funct";
-    initEmulator(new MemoryStore(0, MEMORY_SIZE, argv[1]), baseFilename);
+    if (initEmulator(new MemoryStore(0, MEMORY_SIZE, argv[1]), baseFilename, options) !=
+        SUCCESS) {
+        return ERROR;
+    }
 
     cout << "[Simulator] Start emulation" << endl;
     auto status = runTillHalt();
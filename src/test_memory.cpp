@@ -26,7 +26,8 @@ int main(int argc, char** argv) {
 
     auto mem = new MemoryStore(0, MEMORY_SIZE, argv[1]);
 
-    for (int i = 0; i < MEMORY_SIZE; i+=WORD_SIZE) {
+    // Memory now spans 4 GB, only scan the first 64 KB where programs are loaded.
+    for (uint32_t i = 0; i < 0x10000; i+=WORD_SIZE) {
         uint32_t value;
         mem->getMemValue(i, value, WORD_SIZE);
         if (value != 0) cout << hex << "Memory[" << i << "] = " << value << endl;
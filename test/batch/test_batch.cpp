@@ -0,0 +1,180 @@
+#include "Batch.h"
+#include "cycle.h"
+#include "iostream"
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+// Stores and reloads 20 words, one per D-cache block, then halts
+static const uint32_t PROGRAM[] = {0x24080014, 0x240a0100, 0xad480000, 0x8d490000, 0x01695821,
+                                   0x254a0010, 0x2508ffff, 0x1d00fffa, 0x00000000, 0xfeedfeed};
+
+static void writeInputs() {
+    ofstream program("test_batch.bin", ios::binary);
+    for (uint32_t word : PROGRAM) {
+        uint8_t bytes[] = {uint8_t(word >> 24), uint8_t(word >> 16), uint8_t(word >> 8),
+                           uint8_t(word)};
+        program.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+    }
+    ofstream config("test_batch_config.txt");
+    config << "2048\n16\n2\n5\n4096\n16\n4\n8\n";
+    // A word running past the end of memory
+    ofstream badImage("test_batch_bad_image");
+    badImage << "ffffffff 1\n";
+}
+
+static bool parse(const string& manifest, vector<BatchJob>& jobs) {
+    istringstream in(manifest);
+    return readManifest(in, "manifest", jobs);
+}
+
+static size_t countLines(const string& text) {
+    size_t lines = 0;
+    for (char c : text) lines += c == '\n';
+    return lines;
+}
+
+// Runs the program on a fresh simulator without file output, returns the stats of each core
+static vector<SimulationStats> simulate(const SimOptions& options) {
+    CacheConfig icConfig = {.cacheSize = 2048, .blockSize = 16, .ways = 2, .missLatency = 5};
+    CacheConfig dcConfig = {.cacheSize = 4096, .blockSize = 16, .ways = 4, .missLatency = 8};
+    MemoryStore* memory = new MemoryStore(0, MEMORY_SIZE, nullptr, nullptr);
+    for (uint32_t i = 0; i < sizeof(PROGRAM) / sizeof(PROGRAM[0]); i++) {
+        memory->setMemValue(i * 4, PROGRAM[i], WORD_SIZE);
+    }
+    CycleSimulator simulator;
+    assert(simulator.init(icConfig, dcConfig, memory, "", options) == SUCCESS);
+    assert(simulator.runTillHalt() == HALT);
+    vector<SimulationStats> stats;
+    for (uint32_t core = 0; core < options.cores; core++) stats.push_back(simulator.getStats(core));
+    return stats;
+}
+
+static bool sameStats(const SimulationStats& lhs, const SimulationStats& rhs) {
+    return lhs.dynamicInstructions == rhs.dynamicInstructions &&
+           lhs.totalCycles == rhs.totalCycles && lhs.icHits == rhs.icHits &&
+           lhs.icMisses == rhs.icMisses && lhs.dcHits == rhs.dcHits &&
+           lhs.dcMisses == rhs.dcMisses && lhs.loadStalls == rhs.loadStalls;
+}
+
+// Tests manifest parsing, result rows and running jobs of sim_batch, and that independent
+// CycleSimulators on different threads give the same results as serial runs.
+int main() {
+
+    cout << "Testing sim_batch manifests!" << endl;
+
+    vector<BatchJob> jobs;
+    assert(parse("# comment\n"
+                 "\n"
+                 "a.bin cfg.txt\n"
+                 "  b.bin cfg.txt --cores 2 --msi --init-image img --mem-range range\n",
+                 jobs));
+    assert(jobs.size() == 2);
+    assert(jobs[0].index == 0 && jobs[0].binary == "a.bin" && jobs[0].cacheConfig == "cfg.txt");
+    assert(jobs[0].optionText.empty() && jobs[0].options.cores == 1);
+    assert(jobs[0].options.memRangeFile.empty());
+    assert(jobs[1].index == 1 && jobs[1].initImage == "img");
+    assert(jobs[1].options.cores == 2 && jobs[1].options.protocol == PROTOCOL_MSI);
+    assert(jobs[1].options.memRangeFile == "range");
+    assert(jobs[1].optionText == "--cores 2 --msi --init-image img --mem-range range");
+
+    // The first bad line fails the whole manifest
+    const char* badLines[] = {"a.bin\n", "a.bin cfg.txt --bogus\n", "a.bin cfg.txt --cores 0\n",
+                              "a.bin cfg.txt --cores\n", "a.bin cfg.txt --store-buffer x\n",
+                              "a.bin cfg.txt --mult-latency 0\n"};
+    for (const char* line : badLines) {
+        jobs.clear();
+        assert(!parse(string("a.bin cfg.txt\n") + line, jobs));
+    }
+
+    cout << "Testing sim_batch result rows!" << endl;
+
+    jobs.clear();
+    assert(parse("dir,1/a.bin cfg.txt --cores 2\n", jobs));
+    BatchResult result{HALT, vector<SimulationStats>(2), 1.5, "out/job0"};
+    result.stats[0].totalCycles = 100;
+    result.stats[1].totalCycles = 120;
+    string csv = formatResult(jobs[0], result, false);
+    assert(countLines(csv) == 2);
+    assert(csv.find("0,0,\"dir,1/a.bin\",cfg.txt,--cores 2,halt,0,100,") == 0);
+    assert(csv.find("\n0,1,\"dir,1/a.bin\",cfg.txt,--cores 2,halt,0,120,") != string::npos);
+    // As many fields as the header, counting the quoted comma once
+    size_t headerFields = 1, rowFields = 0;
+    for (char c : string(BATCH_CSV_HEADER)) headerFields += c == ',';
+    for (char c : csv.substr(0, csv.find('\n'))) rowFields += c == ',';
+    assert(rowFields == headerFields);
+    assert(csv.find(",1.500,out/job0\n") != string::npos);
+
+    jobs[0].optionText = "say \"hi\"";
+    string jsonl = formatResult(jobs[0], result, true);
+    assert(countLines(jsonl) == 2);
+    assert(jsonl.find("{\"job\":0,\"core\":0,\"binary\":\"dir,1/a.bin\",") == 0);
+    assert(jsonl.find("\"options\":\"say \\\"hi\\\"\"") != string::npos);
+    assert(jsonl.find("{\"job\":0,\"core\":1,") != string::npos);
+    assert(jsonl.find("\"cycles\":120,") != string::npos);
+
+    cout << "Testing sim_batch jobs!" << endl;
+
+    writeInputs();
+    assert(makeDir("test_batch_out"));
+    jobs.clear();
+    assert(parse("test_batch.bin test_batch_config.txt\n"
+                 "test_batch.bin test_batch_config.txt --cores 2\n"
+                 "test_batch.bin test_batch_config.txt --init-image test_batch_bad_image\n"
+                 "missing.bin test_batch_config.txt\n",
+                 jobs));
+    ImageCache imageCache;
+    // A print_mem_range in the current directory must not change the dump of a job
+    {
+        ofstream range("print_mem_range");
+        range << "0 10\n";
+    }
+    BatchResult single = runJob(jobs[0], imageCache, "test_batch_out");
+    remove("print_mem_range");
+    assert(single.status == HALT && single.stats.size() == 1);
+    assert(single.stats[0].dynamicInstructions == 2 + 20 * 7 + 1);
+    assert(single.stats[0].dcMisses == 20);
+    ifstream memState(single.dir + "/test_batch_cycle_mem_state.out");
+    string memText((istreambuf_iterator<char>(memState)), istreambuf_iterator<char>());
+    assert(memText.find("0x000001e0: ") != string::npos);
+    BatchResult multi = runJob(jobs[1], imageCache, "test_batch_out");
+    assert(multi.status == HALT && multi.stats.size() == 2);
+    assert(multi.stats[1].dynamicInstructions == single.stats[0].dynamicInstructions);
+    // A bad input fails its own job only
+    BatchResult badImage = runJob(jobs[2], imageCache, "test_batch_out");
+    assert(badImage.status == ERROR && countLines(formatResult(jobs[2], badImage, false)) == 1);
+    assert(runJob(jobs[3], imageCache, "test_batch_out").status == ERROR);
+
+    cout << "Testing concurrent simulators!" << endl;
+
+    SimOptions options;
+    options.fileOutput = false;
+    SimOptions multiOptions = options;
+    multiOptions.cores = 2;
+    vector<SimulationStats> serial = simulate(options);
+    vector<SimulationStats> serialMulti = simulate(multiOptions);
+    assert(sameStats(serial[0], single.stats[0]));
+    assert(sameStats(serialMulti[1], multi.stats[1]));
+
+    for (int round = 0; round < 4; round++) {
+        vector<SimulationStats> first, second;
+        thread a([&]() { first = simulate(options); });
+        thread b([&]() { second = simulate(multiOptions); });
+        a.join();
+        b.join();
+        assert(sameStats(first[0], serial[0]));
+        assert(sameStats(second[0], serialMulti[0]) && sameStats(second[1], serialMulti[1]));
+    }
+
+    for (const char* input : {"test_batch.bin", "test_batch_config.txt", "test_batch_bad_image"}) {
+        remove(input);
+    }
+    filesystem::remove_all("test_batch_out");
+    cout << "Cycles: " << serial[0].totalCycles << endl;
+    cout << "Success..." << endl;
+}
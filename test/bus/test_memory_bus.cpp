@@ -0,0 +1,58 @@
+#include "MemoryBus.h"
+#include "iostream"
+#include <cassert>
+
+using namespace std;
+
+// Tests transfer times, queueing of simultaneous misses and the arbitration policies.
+int main() {
+
+    cout << "Testing memory bus!" << endl;
+
+    const uint32_t blockBytes[DRAM_SOURCES] = {16, 32};
+    bool both[DRAM_SOURCES] = {true, true};
+    bool dataOnly[DRAM_SOURCES] = {false, true};
+
+    // 8 bytes per cycle: 2 cycles per I-cache block, 4 per D-cache block
+    MemoryBus bus(8, BUS_IFETCH_FIRST);
+    assert(bus.transferCycles(16) == 2 && bus.transferCycles(20) == 3);
+
+    // A lone miss does not wait, and its latency covers the transfer
+    uint32_t latencies[DRAM_SOURCES] = {5, 2};
+    bus.arbitrate(0, dataOnly, blockBytes, latencies);
+    assert(latencies[DRAM_DATA] == 4);
+
+    // Both miss while the bus is still busy until cycle 4: the I-cache goes first
+    latencies[DRAM_IFETCH] = 5;
+    latencies[DRAM_DATA] = 8;
+    bus.arbitrate(2, both, blockBytes, latencies);
+    assert(latencies[DRAM_IFETCH] == 2 + 5);
+    assert(latencies[DRAM_DATA] == 4 + 8);
+
+    BusStats stats = bus.getStats();
+    assert(stats.transfers == 3 && stats.busyCycles == 4 + 2 + 4 && stats.waitCycles == 2 + 4);
+
+    // D-cache first
+    MemoryBus dataFirst(16, BUS_DATA_FIRST);
+    latencies[DRAM_IFETCH] = 5;
+    latencies[DRAM_DATA] = 8;
+    dataFirst.arbitrate(0, both, blockBytes, latencies);
+    assert(latencies[DRAM_DATA] == 8 && latencies[DRAM_IFETCH] == 2 + 5);
+
+    // Round-robin alternates who goes first
+    MemoryBus roundRobin(16, BUS_ROUND_ROBIN);
+    latencies[DRAM_IFETCH] = 5;
+    latencies[DRAM_DATA] = 8;
+    roundRobin.arbitrate(0, both, blockBytes, latencies);
+    assert(latencies[DRAM_IFETCH] == 5 && latencies[DRAM_DATA] == 1 + 8);
+    latencies[DRAM_IFETCH] = 5;
+    latencies[DRAM_DATA] = 8;
+    roundRobin.arbitrate(100, both, blockBytes, latencies);
+    assert(latencies[DRAM_DATA] == 8 && latencies[DRAM_IFETCH] == 2 + 5);
+
+    BusPolicy policy;
+    assert(parseBusPolicy("data", policy) && policy == BUS_DATA_FIRST);
+    assert(!parseBusPolicy("fifo", policy));
+
+    cout << "Success..." << endl;
+}
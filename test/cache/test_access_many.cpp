@@ -0,0 +1,42 @@
+#include "cache.h"
+#include "iostream"
+#include <cassert>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// Tests that the batched accessMany() gives the same hits and misses as access().
+int main() {
+
+    cout << "Testing accessMany() against access()!" << endl;
+
+    CacheConfig config = {
+        .cacheSize = 1024,
+        .blockSize = 16,
+        .ways = 4,
+        .missLatency = 1,
+    };
+
+    mt19937 generator(375);
+    uniform_int_distribution<uint32_t> distribution(0, 8191);
+    vector<uint32_t> addresses(100000);
+    for (auto& address : addresses) address = distribution(generator) & ~3u;
+
+    Cache single = Cache(config, D_CACHE);
+    Cache batched = Cache(config, D_CACHE);
+    uint32_t singleHits = 0;
+    for (uint32_t address : addresses) singleHits += single.access(address, CACHE_READ);
+
+    uint32_t batchedHits = batched.accessMany(addresses.data(), 3);
+    batchedHits += batched.accessMany(addresses.data() + 3, addresses.size() - 3);
+
+    assert(batchedHits == singleHits);
+    assert(batched.getHits() == single.getHits());
+    assert(batched.getMisses() == single.getMisses());
+
+    cout << "Hits: " << batched.getHits() << endl;
+    cout << "Misses: " << batched.getMisses() << endl;
+
+    cout << "Success..." << endl;
+}
@@ -0,0 +1,53 @@
+#include "cache.h"
+#include "iostream"
+#include <cassert>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// Runs the same addresses through the generic Cache and a HashLRUCache.
+static void compare(const CacheConfig& config, const vector<uint32_t>& addresses) {
+    Cache generic = Cache(config, D_CACHE);
+    HashLRUCache hashed = HashLRUCache(config);
+
+    for (uint32_t address : addresses) {
+        bool expected = generic.access(address, CACHE_READ);
+        assert(hashed.access(address, CACHE_READ) == expected);
+    }
+    assert(hashed.getHits() == generic.getHits());
+    assert(hashed.getMisses() == generic.getMisses());
+
+    cout << config.cacheSize << "B " << config.ways << "-way " << config.blockSize
+         << "B blocks: " << hashed.getHits() << " hits, " << hashed.getMisses() << " misses"
+         << endl;
+}
+
+// Tests that the hash-indexed LRU cache behaves exactly like the generic Cache.
+int main() {
+
+    cout << "Testing HashLRUCache against the generic Cache!" << endl;
+
+    mt19937 generator(375);
+    uniform_int_distribution<uint32_t> distribution(0, 65535);
+    vector<uint32_t> addresses(50000);
+    for (auto& address : addresses) address = distribution(generator) & ~3u;
+
+    // Fully associative
+    compare({.cacheSize = 8192, .blockSize = 16, .ways = 512, .missLatency = 1}, addresses);
+    compare({.cacheSize = 256, .blockSize = 16, .ways = 16, .missLatency = 1}, addresses);
+    // Highly associative, several sets
+    compare({.cacheSize = 4096, .blockSize = 32, .ways = 32, .missLatency = 1}, addresses);
+
+    // Every block of a fully associative cache stays resident until capacity is exceeded
+    CacheConfig config = {.cacheSize = 1024, .blockSize = 16, .ways = 64, .missLatency = 1};
+    HashLRUCache cache = HashLRUCache(config);
+    for (uint32_t block = 0; block < 64; block++) assert(!cache.access(block * 16, CACHE_READ));
+    for (uint32_t block = 0; block < 64; block++) assert(cache.access(block * 16, CACHE_READ));
+    // Block 0 is now the LRU one and gets evicted by block 64
+    assert(!cache.access(64 * 16, CACHE_READ));
+    assert(!cache.access(0, CACHE_READ));
+    assert(cache.access(64 * 16, CACHE_READ));
+
+    cout << "Success..." << endl;
+}
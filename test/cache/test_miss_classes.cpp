@@ -0,0 +1,46 @@
+#include "cache.h"
+#include "iostream"
+#include <cassert>
+#include <memory>
+
+using namespace std;
+
+// Tests that misses are sorted into compulsory, capacity and conflict misses.
+int main() {
+
+    cout << "Testing 3C miss classification!" << endl;
+
+    // Direct-mapped, 4 sets of 16 byte blocks: addresses 64 bytes apart share a set.
+    CacheConfig config = {.cacheSize = 64, .blockSize = 16, .ways = 1, .missLatency = 1};
+    unique_ptr<CacheModel> cache(createCache(config, D_CACHE));
+    cache->enableMissClassification();
+
+    // First touches are compulsory
+    assert(!cache->access(0x000, CACHE_READ));
+    assert(!cache->access(0x040, CACHE_READ));
+    // 0x000 was evicted by 0x040 although the cache has room for it: conflict
+    assert(!cache->access(0x000, CACHE_READ));
+    MissClassStats stats = cache->getMissClasses();
+    assert(stats.compulsory == 2 && stats.capacity == 0 && stats.conflict == 1);
+
+    // Touch more blocks than the cache holds, then come back to the first: capacity
+    for (uint32_t address = 0x100; address < 0x100 + 5 * 16; address += 16) {
+        cache->access(address, CACHE_READ);
+    }
+    assert(!cache->access(0x100, CACHE_READ));
+    stats = cache->getMissClasses();
+    assert(stats.compulsory == 7);
+    assert(stats.capacity == 1);
+    assert(stats.compulsory + stats.capacity + stats.conflict == cache->getMisses());
+
+    // Classification is off by default
+    unique_ptr<CacheModel> plain(createCache(config, D_CACHE));
+    plain->access(0, CACHE_READ);
+    assert(plain->getMissClasses().compulsory == 0);
+
+    cout << "Compulsory: " << stats.compulsory << endl;
+    cout << "Capacity: " << stats.capacity << endl;
+    cout << "Conflict: " << stats.conflict << endl;
+
+    cout << "Success..." << endl;
+}
@@ -0,0 +1,76 @@
+#include "cache.h"
+#include "iostream"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+// Alternates between three blocks that map to set 1 of a 2-way cache with 4 sets of 16 bytes.
+static void thrash(CacheModel& cache) {
+    cache.enableSetStats();
+    for (int i = 0; i < 4; i++) {
+        cache.access(0x010, CACHE_READ);
+        cache.access(0x050, CACHE_READ);
+        cache.access(0x090, CACHE_READ);
+    }
+    cache.access(0x000, CACHE_READ);
+
+    SetStats* stats = cache.getSetStats();
+    assert(stats);
+    assert(stats->getAccesses(1) == 12 && stats->getMisses(1) == 12);
+    // The first two misses fill the empty ways, every later one evicts
+    assert(stats->getEvictions(1) == 10);
+    assert(stats->getAccesses(0) == 1 && stats->getMisses(0) == 1);
+    assert(stats->getEvictions(0) == 0);
+    assert(stats->getBlockEvictions(0x010) == 4);
+    assert(stats->getBlockEvictions(0x050) == 3);
+    assert(stats->getBlockEvictions(0x090) == 3);
+    assert(stats->getBlockEvictions(0x000) == 0);
+}
+
+// Tests the per-set and per-block counters of every cache model.
+int main() {
+
+    cout << "Testing per-set cache stats!" << endl;
+
+    CacheConfig config = {.cacheSize = 128, .blockSize = 16, .ways = 2, .missLatency = 1};
+    Cache generic = Cache(config, D_CACHE);
+    thrash(generic);
+    unique_ptr<CacheModel> specialized(createCache(
+        {.cacheSize = 512, .blockSize = 16, .ways = 2, .missLatency = 1}, D_CACHE));
+    HashLRUCache hashed = HashLRUCache(config);
+    thrash(hashed);
+
+    // With 16 sets, blocks 0x100 apart share set 1
+    specialized->enableSetStats();
+    for (int i = 0; i < 4; i++) {
+        specialized->access(0x010, CACHE_READ);
+        specialized->access(0x110, CACHE_READ);
+        specialized->access(0x210, CACHE_READ);
+    }
+    assert(specialized->getSetStats()->getEvictions(1) == 10);
+    assert(specialized->getSetStats()->getBlockEvictions(0x010) == 4);
+
+    assert(generic.dump("test_set_stats") == SUCCESS);
+    ifstream heatmap("test_set_stats_set_heatmap.csv");
+    string header, set0, set1;
+    getline(heatmap, header);
+    getline(heatmap, set0);
+    getline(heatmap, set1);
+    cout << header << endl << set0 << endl << set1 << endl;
+    assert(header == "set,accesses,misses,evictions,miss_rate");
+    assert(set1 == "1,12,12,10,1.0000");
+
+    // Set stats are off by default
+    Cache plain = Cache(config, D_CACHE);
+    assert(plain.getSetStats() == nullptr);
+
+    heatmap.close();
+    for (const char* suffix : {"_cache_state.out", "_evictions.csv", "_set_heatmap.csv"}) {
+        remove((string("test_set_stats") + suffix).c_str());
+    }
+    cout << "Success..." << endl;
+}
@@ -0,0 +1,46 @@
+#include "cache.h"
+#include "iostream"
+#include <cassert>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// Runs the same addresses through the generic Cache and the createCache() model for a geometry.
+static void compare(const CacheConfig& config, const vector<uint32_t>& addresses) {
+    Cache generic = Cache(config, D_CACHE);
+    unique_ptr<CacheModel> model(createCache(config, D_CACHE));
+
+    for (uint32_t address : addresses) {
+        bool expected = generic.access(address, CACHE_READ);
+        assert(model->access(address, CACHE_READ) == expected);
+    }
+    assert(model->getHits() == generic.getHits());
+    assert(model->getMisses() == generic.getMisses());
+
+    cout << config.cacheSize << "B " << config.ways << "-way " << config.blockSize
+         << "B blocks: " << model->getHits() << " hits, " << model->getMisses() << " misses"
+         << endl;
+}
+
+// Tests that the specialized StaticCache models behave exactly like the generic Cache.
+int main() {
+
+    cout << "Testing createCache() against the generic Cache!" << endl;
+
+    mt19937 generator(375);
+    uniform_int_distribution<uint32_t> distribution(0, 65535);
+    vector<uint32_t> addresses(50000);
+    for (auto& address : addresses) address = distribution(generator) & ~3u;
+
+    // Specialized geometries
+    compare({.cacheSize = 1024, .blockSize = 16, .ways = 4, .missLatency = 1}, addresses);
+    compare({.cacheSize = 512, .blockSize = 32, .ways = 1, .missLatency = 1}, addresses);
+    compare({.cacheSize = 4096, .blockSize = 64, .ways = 8, .missLatency = 1}, addresses);
+    // Falls back to the generic Cache
+    compare({.cacheSize = 256, .blockSize = 16, .ways = 12, .missLatency = 1}, addresses);
+    compare({.cacheSize = 96, .blockSize = 16, .ways = 2, .missLatency = 1}, addresses);
+
+    cout << "Success..." << endl;
+}
@@ -0,0 +1,112 @@
+#include "Coherence.h"
+#include "iostream"
+#include <cassert>
+
+using namespace std;
+
+// Tests the MSI and MESI state transitions and the latencies charged to the requester.
+int main() {
+
+    cout << "Testing MSI/MESI coherent caches!" << endl;
+
+    CacheConfig config = {.cacheSize = 256, .blockSize = 16, .ways = 2, .missLatency = 10};
+
+    // MESI: a read miss nobody else holds is granted Exclusive and writes silently
+    CoherenceBus mesi(PROTOCOL_MESI);
+    CoherentCache a(config, &mesi), b(config, &mesi);
+    mesi.attach(&a);
+    mesi.attach(&b);
+
+    assert(!a.access(0x100, CACHE_READ));
+    assert(a.getState(0x100) == LINE_EXCLUSIVE);
+    assert(a.access(0x104, CACHE_WRITE) && a.getPenalty() == 0);
+    assert(a.getState(0x100) == LINE_MODIFIED);
+
+    // Another core reads it: the owner intervenes and both end up Shared
+    assert(!b.access(0x108, CACHE_READ));
+    assert(b.getPenalty() == COHERENCE_INTERVENTION_LATENCY);
+    assert(a.getState(0x100) == LINE_SHARED && b.getState(0x100) == LINE_SHARED);
+    assert(b.getStats().interventions == 1);
+
+    // Writing a Shared copy is a hit that invalidates the other copy
+    assert(b.access(0x100, CACHE_WRITE));
+    assert(b.getPenalty() == COHERENCE_INVALIDATE_LATENCY);
+    assert(b.getState(0x100) == LINE_MODIFIED && a.getState(0x100) == LINE_INVALID);
+    assert(b.getStats().upgrades == 1 && b.getStats().invalidationsSent == 1);
+    assert(a.getStats().invalidationsReceived == 1);
+
+    // The next miss on the invalidated block is a coherence miss
+    assert(!a.access(0x100, CACHE_WRITE));
+    assert(a.getPenalty() == COHERENCE_INVALIDATE_LATENCY + COHERENCE_INTERVENTION_LATENCY);
+    assert(a.getStats().coherenceMisses == 1);
+    assert(a.getState(0x100) == LINE_MODIFIED && b.getState(0x100) == LINE_INVALID);
+
+    // MSI: no Exclusive state, so a write after a private read still goes to the bus
+    CoherenceBus msi(PROTOCOL_MSI);
+    CoherentCache c(config, &msi), d(config, &msi);
+    msi.attach(&c);
+    msi.attach(&d);
+
+    assert(!c.access(0x200, CACHE_READ));
+    assert(c.getState(0x200) == LINE_SHARED);
+    assert(c.access(0x200, CACHE_WRITE));
+    assert(c.getStats().upgrades == 1 && c.getPenalty() == 0);
+    assert(c.getState(0x200) == LINE_MODIFIED);
+
+    // Evictions stay private: filling the set pushes out the LRU block
+    assert(!d.access(0x000, CACHE_READ));
+    assert(!d.access(0x080, CACHE_READ));
+    assert(d.access(0x000, CACHE_READ));
+    assert(!d.access(0x300, CACHE_READ));
+    assert(d.getState(0x080) == LINE_INVALID && d.getState(0x000) == LINE_SHARED);
+    assert(d.getStats().coherenceMisses == 0);
+
+    // Deferred accesses wait in the mailbox until drain(), which replays them ordered by
+    // cycle and then by core, and hands what they took beyond the core's guess to the core
+    CoherenceBus parallel(PROTOCOL_MESI);
+    CoherentCache e(config, &parallel), f(config, &parallel);
+    parallel.attach(&e);
+    parallel.attach(&f);
+    e.setDeferred(true);
+    f.setDeferred(true);
+
+    f.setCycle(5);
+    assert(!f.access(0x400, CACHE_WRITE));
+    e.setCycle(3);
+    assert(!e.access(0x400, CACHE_READ));
+    assert(e.getPenalty() == 0 && f.getPenalty() == 0);
+    assert(e.getState(0x400) == LINE_INVALID && f.getState(0x400) == LINE_INVALID);
+    assert(e.getMailbox().size() == 1 && f.getMailbox().size() == 1);
+    parallel.drain();
+    assert(e.getMailbox().empty() && f.getMailbox().empty());
+    // e's read goes first and nobody has the block, then f's write invalidates e
+    assert(e.getState(0x400) == LINE_INVALID && f.getState(0x400) == LINE_MODIFIED);
+    assert(e.getStats().interventions == 0 && e.takeCorrection(false) == 0);
+    assert(f.getStats().invalidationsSent == 1 && e.getStats().invalidationsReceived == 1);
+    assert(f.takeCorrection(false) == (int32_t)COHERENCE_INVALIDATE_LATENCY);
+    assert(f.takeCorrection(false) == 0);
+    assert(e.getMisses() == 1 && f.getMisses() == 1);
+
+    // A hit on a block an earlier core invalidated in the same cycle turns into a miss
+    e.setCycle(6);
+    f.setCycle(6);
+    assert(f.access(0x400, CACHE_READ));
+    assert(!e.access(0x400, CACHE_WRITE));
+    parallel.drain();
+    assert(e.getState(0x400) == LINE_SHARED && f.getState(0x400) == LINE_SHARED);
+    assert(e.takeCorrection(false) ==
+           (int32_t)(COHERENCE_INVALIDATE_LATENCY + COHERENCE_INTERVENTION_LATENCY));
+    assert(f.takeCorrection(false) ==
+           (int32_t)(config.missLatency + COHERENCE_INTERVENTION_LATENCY));
+    assert(f.getHits() == 0 && f.getMisses() == 2 && f.getStats().coherenceMisses == 1);
+
+    // Store drains are kept apart, and a posted read nobody else holds becomes Exclusive
+    e.setCycle(7, true);
+    assert(!e.access(0x600, CACHE_READ));
+    parallel.drain();
+    assert(e.getState(0x600) == LINE_EXCLUSIVE);
+    assert(e.takeCorrection(false) == 0 && e.takeCorrection(true) == 0);
+
+    cout << "Coherence misses: " << a.getStats().coherenceMisses << endl;
+    cout << "Success..." << endl;
+}
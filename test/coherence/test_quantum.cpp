@@ -0,0 +1,68 @@
+#include "cycle.h"
+#include "iostream"
+#include <cassert>
+#include <vector>
+
+using namespace std;
+
+// Every core stores and reloads 20 words, one per D-cache block, at the same addresses
+static const uint32_t PROGRAM[] = {0x24080014, 0x240a0100, 0xad480000, 0x8d490000, 0x01695821,
+                                   0x254a0010, 0x2508ffff, 0x1d00fffa, 0x00000000, 0xfeedfeed};
+
+static vector<SimulationStats> simulate(const SimOptions& options) {
+    CacheConfig icConfig = {.cacheSize = 2048, .blockSize = 16, .ways = 2, .missLatency = 5};
+    CacheConfig dcConfig = {.cacheSize = 4096, .blockSize = 16, .ways = 4, .missLatency = 8};
+    MemoryStore* memory = new MemoryStore(0, MEMORY_SIZE, nullptr, nullptr);
+    for (uint32_t i = 0; i < sizeof(PROGRAM) / sizeof(PROGRAM[0]); i++) {
+        memory->setMemValue(i * 4, PROGRAM[i], WORD_SIZE);
+    }
+    CycleSimulator simulator;
+    assert(simulator.init(icConfig, dcConfig, memory, "", options) == SUCCESS);
+    assert(simulator.runTillHalt() == HALT);
+    vector<SimulationStats> stats;
+    for (uint32_t core = 0; core < options.cores; core++) stats.push_back(simulator.getStats(core));
+    return stats;
+}
+
+// Runs options in lockstep and with a quantum of one cycle, which has to give the same stats
+static vector<SimulationStats> compareQuantum(SimOptions options) {
+    options.quantum = 0;
+    vector<SimulationStats> lockstep = simulate(options);
+    options.quantum = 1;
+    vector<SimulationStats> parallel = simulate(options);
+    for (uint32_t core = 0; core < options.cores; core++) {
+        assert(parallel[core].dynamicInstructions == lockstep[core].dynamicInstructions);
+        assert(parallel[core].totalCycles == lockstep[core].totalCycles);
+        assert(parallel[core].dcHits == lockstep[core].dcHits);
+        assert(parallel[core].dcMisses == lockstep[core].dcMisses);
+        assert(parallel[core].loadStalls == lockstep[core].loadStalls);
+    }
+    return lockstep;
+}
+
+// Tests that parallel runs with a quantum of one cycle charge every coherence penalty to the
+// access that caused it, as lockstep runs do, while the cores fight over the same blocks.
+int main() {
+
+    cout << "Testing parallel runs against lockstep!" << endl;
+
+    SimOptions options;
+    options.fileOutput = false;
+    uint32_t alone = simulate(options)[0].totalCycles;
+
+    options.cores = 4;
+    vector<SimulationStats> mesi = compareQuantum(options);
+    // The later cores find the blocks modified by the earlier ones
+    assert(mesi[3].totalCycles > alone);
+
+    options.protocol = PROTOCOL_MSI;
+    compareQuantum(options);
+
+    options.protocol = PROTOCOL_MESI;
+    options.cores = 3;
+    options.storeBufferDepth = 2;
+    compareQuantum(options);
+
+    cout << "Cycles: " << alone << " alone, " << mesi[3].totalCycles << " on core 3 of 4" << endl;
+    cout << "Success..." << endl;
+}
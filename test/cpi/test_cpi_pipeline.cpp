@@ -0,0 +1,76 @@
+#include "cycle.h"
+#include "iostream"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+using namespace std;
+
+// lw $t0, 0x100($zero); addu $t1, $t0, $t0; halt
+static const uint32_t PROGRAM[] = {0x8c080100, 0x01084821, 0xfeedfeed};
+
+// Cycles per cause from the summary of <base>_cpi_stack.out
+static map<string, uint64_t> readCpiStack(const string& fileName) {
+    ifstream in(fileName);
+    assert(in);
+    map<string, uint64_t> cycles;
+    string line;
+    getline(in, line);  // header
+    while (getline(in, line) && !line.empty()) {
+        // The cause name is left-aligned in 18 columns, the cycles follow
+        istringstream fields(line.substr(18));
+        uint64_t count;
+        fields >> count;
+        cycles[line.substr(0, line.find_last_not_of(' ', 17) + 1)] = count;
+    }
+    return cycles;
+}
+
+// Runs a program with one load-use stall and one D-cache miss through the pipeline and checks
+// the CPI stack charges those cycles to the right causes.
+int main() {
+
+    cout << "Testing the CPI stack of a pipeline run!" << endl;
+
+    CacheConfig icConfig = {.cacheSize = 256, .blockSize = 16, .ways = 1, .missLatency = 5};
+    CacheConfig dcConfig = {.cacheSize = 256, .blockSize = 16, .ways = 1, .missLatency = 8};
+    MemoryStore* memory = new MemoryStore(0, MEMORY_SIZE, nullptr, nullptr);
+    for (uint32_t i = 0; i < sizeof(PROGRAM) / sizeof(PROGRAM[0]); i++) {
+        memory->setMemValue(i * 4, PROGRAM[i], WORD_SIZE);
+    }
+
+    SimOptions options;
+    options.cpiStack = true;
+    CycleSimulator simulator;
+    assert(simulator.init(icConfig, dcConfig, memory, "test_cpi_pipeline", options) == SUCCESS);
+    assert(simulator.runTillHalt() == HALT);
+    simulator.finalize();
+    SimulationStats stats = simulator.getStats();
+    assert(stats.dcMisses == 1 && stats.loadStalls == 1);
+
+    map<string, uint64_t> cycles = readCpiStack("test_cpi_pipeline_cpi_stack.out");
+    for (auto& cause : cycles) cout << cause.first << ": " << cause.second << endl;
+
+    // Every instruction retires once, the load waits missLatency cycles in MEM and the addu
+    // one cycle in ID
+    assert(cycles["Base"] == stats.dynamicInstructions);
+    assert(cycles["D-cache miss"] == dcConfig.missLatency);
+    assert(cycles["Load-use"] == 1);
+    assert(cycles["I-cache miss"] == icConfig.missLatency);
+    assert(cycles["Load-branch"] == 0 && cycles["Arith-branch"] == 0);
+    assert(cycles["Exception squash"] == 0);
+
+    uint64_t total = 0;
+    for (auto& cause : cycles) {
+        if (cause.first != "Total") total += cause.second;
+    }
+    assert(total == stats.totalCycles && cycles["Total"] == stats.totalCycles);
+
+    for (const char* suffix : {"_cpi_stack.out", "_mem_state.out", "_pipe_state.out",
+                               "_reg_state.out", "_sim_stats.out"}) {
+        remove((string("test_cpi_pipeline") + suffix).c_str());
+    }
+    cout << "Success..." << endl;
+}
@@ -0,0 +1,44 @@
+#include "CpiStack.h"
+#include "iostream"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace std;
+
+// Tests the global and per-PC cycle attribution of the CPI stack.
+int main() {
+
+    cout << "Testing the CPI stack!" << endl;
+
+    CpiStack stack;
+    // 4 retired instructions, plus stalls charged to the lw at 0x8 and the beq at 0xc
+    for (uint32_t pc = 0; pc < 16; pc += 4) stack.charge(STALL_NONE, pc, 0);
+    stack.charge(STALL_D_MISS, 0x8, 0x8d090000);
+    stack.charge(STALL_D_MISS, 0x8, 0x8d090000);
+    stack.charge(STALL_LOAD_BRANCH, 0xc, 0x1120fffc);
+    stack.charge(STALL_HALT_DRAIN, 0x10, 0xfeedfeed);
+
+    assert(stack.getCycles(STALL_NONE) == 4);
+    assert(stack.getCycles(STALL_D_MISS) == 2);
+    assert(stack.getCycles(STALL_LOAD_BRANCH) == 1);
+    assert(stack.getCycles(STALL_HALT_DRAIN) == 1);
+    assert(stack.getPCCycles(0x8, STALL_D_MISS) == 2);
+    assert(stack.getPCCycles(0xc, STALL_LOAD_BRANCH) == 1);
+    assert(stack.getPCCycles(0xc, STALL_D_MISS) == 0);
+    // Retired cycles and the fill/drain aren't charged to a PC
+    assert(stack.getPCCycles(0x0, STALL_NONE) == 0);
+    assert(stack.getPCCycles(0x10, STALL_HALT_DRAIN) == 0);
+
+    assert(stack.dump("test_cpi", 4) == SUCCESS);
+    ifstream report("test_cpi_cpi_stack.out");
+    string text((istreambuf_iterator<char>(report)), istreambuf_iterator<char>());
+    cout << text;
+    // The lw has the most stall cycles, so it is ranked first
+    assert(text.find("0x00000008") < text.find("0x0000000c"));
+    assert(text.find("Total                         8    2.000") != string::npos);
+
+    remove("test_cpi_cpi_stack.out");
+    cout << "Success..." << endl;
+}
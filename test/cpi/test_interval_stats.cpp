@@ -0,0 +1,65 @@
+#include "IntervalStats.h"
+#include "iostream"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace std;
+
+static string readFile(const string& fileName) {
+    ifstream in(fileName);
+    return string((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+}
+
+// Tests that the interval writer emits per-interval deltas as CSV and JSON lines.
+int main() {
+
+    cout << "Testing interval stats!" << endl;
+
+    IntervalCounters first;
+    first.cycles = 100;
+    first.instructions = 40;
+    first.icHits = 30;
+    first.icMisses = 10;
+    first.stalls[STALL_I_MISS] = 60;
+    IntervalCounters second = first;
+    second.cycles = 150;
+    second.instructions = 90;
+    second.icHits = 80;
+    second.dcMisses = 2;
+
+    {
+        IntervalWriter writer(100, false, INTERVAL_CSV);
+        assert(writer.open("test_intervals.csv") == SUCCESS);
+        assert(!writer.isDue(99, 1000));
+        assert(writer.isDue(100, 0));
+        writer.sample(first);
+        assert(!writer.isDue(150, 90));
+        writer.finish(second);
+    }
+    string csv = readFile("test_intervals.csv");
+    cout << csv;
+    assert(csv.find("interval,end_cycle,end_instructions,cycles,instructions,ipc,") == 0);
+    assert(csv.find("\n0,100,40,100,40,0.4000,30,10,0,0,60,0,0,0,0,0,0,0\n") != string::npos);
+    assert(csv.find("\n1,150,90,50,50,1.0000,50,0,0,2,0,0,0,0,0,0,0,0\n") != string::npos);
+
+    {
+        IntervalWriter writer(40, true, INTERVAL_JSONL);
+        assert(writer.open("test_intervals.jsonl") == SUCCESS);
+        assert(writer.isDue(0, 40));
+        writer.sample(first);
+        // Nothing ran since the last row, so finish() adds none
+        writer.finish(first);
+    }
+    string jsonl = readFile("test_intervals.jsonl");
+    cout << jsonl;
+    assert(jsonl.find("{\"interval\":0,\"end_cycle\":100,") == 0);
+    assert(jsonl.find("\"ipc\":0.4000,\"ic_hits\":30,") != string::npos);
+    assert(jsonl.find("\"stall_i_miss\":60,") != string::npos);
+    assert(jsonl.find("{\"interval\":1") == string::npos);
+
+    remove("test_intervals.csv");
+    remove("test_intervals.jsonl");
+    cout << "Success..." << endl;
+}
@@ -0,0 +1,60 @@
+#include "Dram.h"
+#include "iostream"
+#include <cassert>
+
+using namespace std;
+
+// Tests row buffer hits, misses and conflicts, the shared data bus and FR-FCFS ordering.
+int main() {
+
+    cout << "Testing DRAM model!" << endl;
+
+    DramConfig config;
+    config.banks = 2;
+    config.rowBytes = 256;
+    config.tCAS = 10;
+    config.tRCD = 20;
+    config.tRP = 30;
+    config.tBurst = 4;
+    uint32_t latencies[DRAM_SOURCES] = {0, 0};
+
+    Dram dram(config);
+    // Closed bank: activate, then read
+    dram.enqueue(DRAM_DATA, 0x000, 0);
+    assert(dram.hasPending());
+    dram.issue(latencies);
+    assert(!dram.hasPending());
+    assert(latencies[DRAM_DATA] == 20 + 10 + 4);
+
+    // Same row later: row hit
+    dram.enqueue(DRAM_DATA, 0x010, 100);
+    dram.issue(latencies);
+    assert(latencies[DRAM_DATA] == 10 + 4);
+
+    // Row 1 of bank 0 (address 512): precharge, activate, read
+    dram.enqueue(DRAM_DATA, 0x200, 200);
+    dram.issue(latencies);
+    assert(latencies[DRAM_DATA] == 30 + 20 + 10 + 4);
+
+    // Two misses in the same cycle: the row hit goes first even though it arrived second,
+    // and the other waits for the data bus
+    dram.enqueue(DRAM_IFETCH, 0x100, 300);  // bank 1, closed
+    dram.enqueue(DRAM_DATA, 0x210, 300);    // bank 0, row 1 open
+    dram.issue(latencies);
+    assert(latencies[DRAM_DATA] == 10 + 4);
+    assert(latencies[DRAM_IFETCH] == 20 + 10 + 4);
+
+    // Both on the same bank: the second waits for the bank
+    dram.enqueue(DRAM_IFETCH, 0x000, 400);
+    dram.enqueue(DRAM_DATA, 0x220, 400);
+    dram.issue(latencies);
+    assert(latencies[DRAM_DATA] == 14);
+    assert(latencies[DRAM_IFETCH] == 10 + 30 + 20 + 10 + 4);
+
+    DramStats stats = dram.getStats();
+    assert(stats.requests == 7);
+    assert(stats.rowHits == 3 && stats.rowMisses == 2 && stats.rowConflicts == 2);
+
+    cout << "Average latency: " << stats.totalLatency / stats.requests << endl;
+    cout << "Success..." << endl;
+}
@@ -0,0 +1,110 @@
+#include "emulator.h"
+#include "iostream"
+#include <cassert>
+
+using namespace std;
+
+static uint32_t rType(uint32_t rs, uint32_t rt, uint32_t rd, uint32_t shamt, uint32_t funct) {
+    return (rs << 21) | (rt << 16) | (rd << 11) | (shamt << 6) | funct;
+}
+
+static uint32_t iType(uint32_t op, uint32_t rs, uint32_t rt, uint16_t imm) {
+    return (op << 26) | (rs << 21) | (rt << 16) | imm;
+}
+
+static uint32_t jType(uint32_t op, uint32_t addr) { return (op << 26) | (addr >> 2); }
+
+// Loop with loads, stores and branches that ends in an overflow; the handler at 0x8000
+// calls a subroutine and halts.
+static void loadProgram(MemoryStore* mem) {
+    const uint32_t T0 = 8, T1 = 9, T2 = 10, T3 = 11, T4 = 12, T5 = 13, S0 = 16, RA = 31;
+    uint32_t program[] = {
+        iType(OP_ADDIU, 0, T0, 5),                // 0x00
+        iType(OP_ADDIU, 0, T1, 0x100),            // 0x04
+        iType(OP_SW, T1, T0, 0),                  // 0x08 loop
+        iType(OP_LW, T1, T2, 0),                  // 0x0c
+        rType(T3, T2, T3, 0, FUN_ADDU),           // 0x10
+        iType(OP_SB, T1, T3, 2),                  // 0x14
+        iType(OP_LHU, T1, T4, 2),                 // 0x18
+        iType(OP_ADDIU, T1, T1, 4),               // 0x1c
+        iType(OP_ADDI, T0, T0, 0xffff),           // 0x20
+        iType(OP_BGTZ, T0, 0, (uint16_t)-8),      // 0x24
+        0,                                        // 0x28
+        iType(OP_LUI, 0, T4, 0x7fff),             // 0x2c
+        rType(T4, T4, T5, 0, FUN_ADD),            // 0x30 overflows
+    };
+    uint32_t handler[] = {
+        iType(OP_ORI, 0, S0, 0x1234),             // 0x8000
+        jType(OP_JAL, 0x8010),                    // 0x8004
+        0,                                        // 0x8008
+        0xfeedfeed,                               // 0x800c
+        rType(RA, 0, 0, 0, FUN_JR),               // 0x8010
+        0,                                        // 0x8014
+    };
+    for (uint32_t i = 0; i < sizeof(program) / sizeof(program[0]); i++)
+        mem->setMemValue(i * 4, program[i], WORD_SIZE);
+    for (uint32_t i = 0; i < sizeof(handler) / sizeof(handler[0]); i++)
+        mem->setMemValue(0x8000 + i * 4, handler[i], WORD_SIZE);
+}
+
+static void assertSameState(Emulator& full, Emulator& fast) {
+    assert(full.getPC() == fast.getPC());
+    assert(full.getDin() == fast.getDin());
+    for (uint32_t r = 0; r < 32; r++) assert(full.getReg(r) == fast.getReg(r));
+    for (uint32_t addr = 0x100; addr < 0x120; addr += 4) {
+        uint32_t a, b;
+        full.getMemory()->getMemValue(addr, a, WORD_SIZE);
+        fast.getMemory()->getMemValue(addr, b, WORD_SIZE);
+        assert(a == b);
+    }
+}
+
+// Runs executeInstruction() and executeFast() in lockstep and checks the architectural
+// state stays identical.
+int main() {
+
+    cout << "Testing executeFast() against executeInstruction()!" << endl;
+
+    Emulator full, fast;
+    full.setMemory(new MemoryStore(0, MEMORY_SIZE));
+    fast.setMemory(new MemoryStore(0, MEMORY_SIZE));
+    loadProgram(full.getMemory());
+    loadProgram(fast.getMemory());
+
+    uint32_t exceptions = 0;
+    for (int i = 0; i < 1000; i++) {
+        Emulator::InstructionInfo info = full.executeInstruction();
+        Emulator::StepResult result = fast.executeFast();
+        assert(info.isHalt == result.isHalt);
+        assert((info.isOverflow || !info.isValid) == result.isException);
+        assertSameState(full, fast);
+        exceptions += result.isException;
+        if (result.isHalt) break;
+    }
+    assert(full.getPC() == 0x8010);
+    assert(exceptions == 1);
+    assert(fast.getReg(16) == 0x1234);
+
+    cout << "Testing step()!" << endl;
+
+    Emulator stepped;
+    stepped.setMemory(new MemoryStore(0, MEMORY_SIZE));
+    loadProgram(stepped.getMemory());
+    Emulator::StepResult result = stepped.step(3);
+    assert(!result.isHalt && !result.isException && stepped.getDin() == 3);
+    result = stepped.step(0);
+    assert(result.isHalt && result.isException);
+    assertSameState(full, stepped);
+
+    cout << "Testing illegal instructions!" << endl;
+
+    Emulator illegal;
+    illegal.setMemory(new MemoryStore(0, MEMORY_SIZE));
+    illegal.getMemory()->setMemValue(0, 0xfc000000, WORD_SIZE);
+    illegal.getMemory()->setMemValue(0x8000, 0xfeedfeed, WORD_SIZE);
+    result = illegal.executeFast();
+    assert(!result.isHalt && result.isException && illegal.getPC() == 0x8000);
+    assert(illegal.executeFast().isHalt);
+
+    cout << "Success..." << endl;
+}
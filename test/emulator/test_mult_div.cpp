@@ -0,0 +1,75 @@
+#include "emulator.h"
+#include "iostream"
+#include <cassert>
+
+using namespace std;
+
+static uint32_t rType(uint32_t rs, uint32_t rt, uint32_t rd, uint32_t shamt, uint32_t funct) {
+    return (rs << 21) | (rt << 16) | (rd << 11) | (shamt << 6) | funct;
+}
+
+static uint32_t iType(uint32_t op, uint32_t rs, uint32_t rt, uint16_t imm) {
+    return (op << 26) | (rs << 21) | (rt << 16) | imm;
+}
+
+// Runs rs <funct> rt on the full and the fast path, returns HI and LO through mfhi/mflo
+static void run(uint32_t funct, uint32_t rs, uint32_t rt, uint32_t& hi, uint32_t& lo) {
+    const uint32_t T0 = 8, T1 = 9, T2 = 10, T3 = 11;
+    uint32_t program[] = {
+        iType(OP_LUI, 0, T0, rs >> 16),
+        iType(OP_ORI, T0, T0, rs & 0xffff),
+        iType(OP_LUI, 0, T1, rt >> 16),
+        iType(OP_ORI, T1, T1, rt & 0xffff),
+        rType(T0, T1, 0, 0, funct),
+        rType(0, 0, T2, 0, FUN_MFHI),
+        rType(0, 0, T3, 0, FUN_MFLO),
+        0xfeedfeed,
+    };
+
+    Emulator full, fast;
+    full.setMemory(new MemoryStore(0, MEMORY_SIZE));
+    fast.setMemory(new MemoryStore(0, MEMORY_SIZE));
+    for (uint32_t i = 0; i < sizeof(program) / sizeof(program[0]); i++) {
+        full.getMemory()->setMemValue(i * 4, program[i], WORD_SIZE);
+        fast.getMemory()->setMemValue(i * 4, program[i], WORD_SIZE);
+    }
+    for (Emulator::InstructionInfo info = full.executeInstruction(); !info.isHalt;
+         info = full.executeInstruction()) {
+        assert(info.isValid && !info.isOverflow);
+    }
+    Emulator::StepResult result = fast.step(0);
+    assert(result.isHalt && !result.isException);
+
+    hi = full.getReg(T2);
+    lo = full.getReg(T3);
+    assert(fast.getReg(T2) == hi && fast.getReg(T3) == lo);
+    assert(full.getHi() == hi && full.getLo() == lo);
+}
+
+// Tests the HI/LO results of mult, multu, div and divu.
+int main() {
+
+    cout << "Testing mult, multu, div and divu!" << endl;
+
+    uint32_t hi, lo;
+    run(FUN_MULT, 7, (uint32_t)-3, hi, lo);
+    assert(hi == 0xffffffff && lo == (uint32_t)-21);
+    run(FUN_MULTU, 7, (uint32_t)-3, hi, lo);
+    assert(hi == 6 && lo == (uint32_t)-21);
+    run(FUN_MULT, 0x80000000, 0x80000000, hi, lo);
+    assert(hi == 0x40000000 && lo == 0);
+
+    // Quotient in LO, remainder in HI with the sign of the dividend
+    run(FUN_DIV, (uint32_t)-7, 2, hi, lo);
+    assert(lo == (uint32_t)-3 && hi == (uint32_t)-1);
+    run(FUN_DIVU, (uint32_t)-7, 2, hi, lo);
+    assert(lo == 0x7ffffffc && hi == 1);
+
+    // Dividing by zero does not trap and leaves HI and LO alone
+    run(FUN_DIV, 5, 0, hi, lo);
+    assert(hi == 0 && lo == 0);
+    run(FUN_DIV, 0x80000000, 0xffffffff, hi, lo);
+    assert(hi == 0 && lo == 0);
+
+    cout << "Success..." << endl;
+}
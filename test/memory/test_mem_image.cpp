@@ -0,0 +1,97 @@
+#include "MemoryStore.h"
+#include "Utilities.h"
+#include "iostream"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+static void writeWord(ofstream& out, uint32_t value) {
+    uint32_t bigEndian = ConvertWordToBigEndian(value);
+    out.write(reinterpret_cast<const char*>(&bigEndian), sizeof(bigEndian));
+}
+
+// Tests that init_mem_image is loaded in both the binary and the text format, and that
+// converted text images load the same memory as the text itself.
+int main() {
+
+    cout << "Testing binary init_mem_image!" << endl;
+    {
+        ofstream out("init_mem_image", ios::binary);
+        out.write(MEM_IMAGE_MAGIC, MEM_IMAGE_MAGIC_LEN);
+        writeWord(out, 0x1000);
+        writeWord(out, 8);
+        writeWord(out, 0xdeadbeef);
+        writeWord(out, 0x11223344);
+        // A segment crossing a page boundary, far above 64 KB.
+        writeWord(out, 0x400ffe);
+        writeWord(out, 4);
+        writeWord(out, 0xa1b2c3d4);
+    }
+
+    uint32_t value = 0;
+    MemoryStore binMem = MemoryStore(0, MEMORY_SIZE);
+    assert(binMem.getMemValue(0x1000, value, WORD_SIZE) == 0 && value == 0xdeadbeef);
+    assert(binMem.getMemValue(0x1004, value, WORD_SIZE) == 0 && value == 0x11223344);
+    assert(binMem.getMemValue(0x400ffe, value, WORD_SIZE) == 0 && value == 0xa1b2c3d4);
+    assert(binMem.getMemValue(0x1008, value, WORD_SIZE) == 0 && value == 0);
+
+    cout << "Testing text init_mem_image fallback!" << endl;
+    {
+        ofstream out("init_mem_image");
+        out << "0x1000 0xdeadbeef" << endl;
+        out << "0x400ffc 0x55" << endl;
+    }
+
+    MemoryStore textMem = MemoryStore(0, MEMORY_SIZE);
+    assert(textMem.getMemValue(0x1000, value, WORD_SIZE) == 0 && value == 0xdeadbeef);
+    assert(textMem.getMemValue(0x400ffc, value, WORD_SIZE) == 0 && value == 0x55);
+    assert(textMem.getMemValue(0, value, WORD_SIZE) == 0 && value == 0);
+
+    cout << "Testing converted text images!" << endl;
+    // Overlapping and unaligned words, out of address order, across a page boundary
+    const char* text = "1002 aabbccdd\n"
+                       "1000 01020304\n"
+                       "\n"
+                       "0x400ffc 0x11111111\n"
+                       "400ff8 22222222\n"
+                       "401000 33333333\n"
+                       "1006 0xeeff\n"
+                       "1004 44444444\n";
+    {
+        ofstream out("init_mem_image");
+        out << text;
+    }
+    MemoryStore expected = MemoryStore(0, MEMORY_SIZE);
+    {
+        istringstream in(text);
+        ofstream out("init_mem_image", ios::binary);
+        uint32_t words = 0, segments = 0;
+        assert(convertMemImage(in, out, words, segments) == 0);
+        assert(words == 7 && segments == 7);
+    }
+    MemoryStore converted = MemoryStore(0, MEMORY_SIZE);
+    assert(converted.getMemValue(0x1000, value, WORD_SIZE) == 0 && value == 0x01020304);
+    assert(converted.getMemValue(0x1004, value, WORD_SIZE) == 0 && value == 0x44444444);
+    assert(converted.getMemValue(0x1008, value, HALF_SIZE) == 0 && value == 0xeeff);
+    for (uint32_t addr : {0xff8u, 0x1000u, 0x1008u, 0x400ff4u, 0x400ffcu, 0x401000u}) {
+        for (uint32_t offset = 0; offset < 16; offset += 4) {
+            uint32_t want = 0;
+            assert(expected.getMemValue(addr + offset, want, WORD_SIZE) == 0);
+            assert(converted.getMemValue(addr + offset, value, WORD_SIZE) == 0 && value == want);
+        }
+    }
+
+    // A malformed line fails the conversion
+    for (const char* bad : {"1000 1\n1004\n", "1000 1\nzz 2\n", "1000 1 2\n"}) {
+        istringstream in(bad);
+        ostringstream out;
+        uint32_t words = 0, segments = 0;
+        assert(convertMemImage(in, out, words, segments) != 0);
+    }
+
+    remove("init_mem_image");
+    cout << "Success..." << endl;
+}
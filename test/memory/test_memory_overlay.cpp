@@ -0,0 +1,52 @@
+#include "MemoryStore.h"
+#include "iostream"
+#include <cassert>
+
+using namespace std;
+
+// Tests that an overlay buffers stores until commit() and forwards them to its own loads.
+int main() {
+
+    cout << "Testing memory overlay!" << endl;
+
+    MemoryStore mem = MemoryStore(0, MEMORY_SIZE);
+    mem.setMemValue(0x1000, 0x11223344, WORD_SIZE);
+    assert(mem.peekByte(0x1001) == 0x22);
+    assert(mem.peekByte(0x7ffff000) == 0);
+
+    MemoryOverlay first(&mem), second(&mem);
+    uint32_t value = 0;
+
+    // Loads fall through to memory
+    assert(first.getMemValue(0x1000, value, WORD_SIZE) == 0 && value == 0x11223344);
+
+    // A partial store is merged with the bytes underneath, only for the storing overlay
+    first.setMemValue(0x1002, 0xabcd, HALF_SIZE);
+    first.getMemValue(0x1000, value, WORD_SIZE);
+    assert(value == 0x1122abcd);
+    second.getMemValue(0x1000, value, WORD_SIZE);
+    assert(value == 0x11223344);
+    mem.getMemValue(0x1000, value, WORD_SIZE);
+    assert(value == 0x11223344);
+
+    // Stores straddling a page boundary
+    first.setMemValue(0x1ffe, 0xdeadbeef, WORD_SIZE);
+    first.getMemValue(0x1ffe, value, WORD_SIZE);
+    assert(value == 0xdeadbeef);
+
+    // Commits apply in call order, so the later one wins on overlapping bytes
+    second.setMemValue(0x1003, 0xee, BYTE_SIZE);
+    first.commit();
+    second.commit();
+    mem.getMemValue(0x1000, value, WORD_SIZE);
+    assert(value == 0x1122abee);
+    mem.getMemValue(0x1ffe, value, WORD_SIZE);
+    assert(value == 0xdeadbeef);
+
+    // Committed overlays are empty again
+    mem.setMemValue(0x1000, 0, WORD_SIZE);
+    first.getMemValue(0x1000, value, WORD_SIZE);
+    assert(value == 0);
+
+    cout << "Success..." << endl;
+}
@@ -0,0 +1,40 @@
+#include "MemoryStore.h"
+#include "iostream"
+#include <cassert>
+
+using namespace std;
+
+// Tests that memory covers the full 32-bit space and that untouched pages read as zero.
+int main() {
+
+    cout << "Testing sparse paged memory!" << endl;
+
+    MemoryStore mem = MemoryStore(0, MEMORY_SIZE);
+    uint32_t value = 0xdeadbeef;
+
+    // Untouched memory anywhere in the address space reads back as zero.
+    assert(mem.getMemValue(0x7ffffff0, value, WORD_SIZE) == 0);
+    assert(value == 0);
+
+    // Accesses far beyond the old 64 KB limit.
+    assert(mem.setMemValue(0x10000, 0x12345678, WORD_SIZE) == 0);
+    assert(mem.setMemValue(0x7ffffffc, 0xcafef00d, WORD_SIZE) == 0);
+    assert(mem.setMemValue(0xfffffffc, 0x0badc0de, WORD_SIZE) == 0);
+    assert(mem.getMemValue(0x10000, value, WORD_SIZE) == 0 && value == 0x12345678);
+    assert(mem.getMemValue(0x7ffffffc, value, WORD_SIZE) == 0 && value == 0xcafef00d);
+    assert(mem.getMemValue(0xfffffffc, value, WORD_SIZE) == 0 && value == 0x0badc0de);
+
+    // Memory is big-endian at every granularity.
+    assert(mem.getMemValue(0x10000, value, BYTE_SIZE) == 0 && value == 0x12);
+    assert(mem.getMemValue(0x10002, value, HALF_SIZE) == 0 && value == 0x5678);
+
+    // A word straddling a page boundary.
+    assert(mem.setMemValue(0x20ffe, 0xa1b2c3d4, WORD_SIZE) == 0);
+    assert(mem.getMemValue(0x20ffe, value, WORD_SIZE) == 0 && value == 0xa1b2c3d4);
+    assert(mem.getMemValue(0x21000, value, HALF_SIZE) == 0 && value == 0xc3d4);
+
+    // Wrapping past the top of the address space is still an access violation.
+    assert(mem.setMemValue(0xfffffffe, 0, WORD_SIZE) != 0);
+
+    cout << "Success..." << endl;
+}
@@ -0,0 +1,89 @@
+#include "MipsSim.h"
+#include "iostream"
+#include <cassert>
+#include <cstring>
+
+using namespace std;
+
+// addi $t0, $zero, 5; addi $t1, $t0, 7; sll $t3, $k0, 2; sw $t1, 0x100($t3);
+// lw $t2, 0x200($zero); halt
+static const uint8_t PROGRAM[] = {0x20, 0x08, 0x00, 0x05, 0x21, 0x09, 0x00, 0x07,
+                                  0x00, 0x1a, 0x58, 0x80, 0xad, 0x69, 0x01, 0x00,
+                                  0x8c, 0x0a, 0x02, 0x00, 0xfe, 0xed, 0xfe, 0xed};
+static const uint8_t DATA[] = {0x12, 0x34, 0x56, 0x78};
+// mult $t0, $t1; mflo $t2; halt
+static const uint8_t MULT_PROGRAM[] = {0x01, 0x09, 0x00, 0x18, 0x00, 0x00, 0x50, 0x12,
+                                       0xfe, 0xed, 0xfe, 0xed};
+
+// Tests the embeddable simulator: loading from buffers and reading results back without files.
+// Link against libmipssim.a.
+int main() {
+
+    cout << "Testing libmipssim!" << endl;
+
+    CacheConfig icConfig = {.cacheSize = 2048, .blockSize = 16, .ways = 2, .missLatency = 5};
+    CacheConfig dcConfig = {.cacheSize = 4096, .blockSize = 16, .ways = 4, .missLatency = 8};
+
+    MipsSim sim(icConfig, dcConfig);
+    assert(sim.load(PROGRAM, sizeof(PROGRAM)) == SUCCESS);
+    assert(sim.load(DATA, sizeof(DATA), 0x200) == SUCCESS);
+    assert(sim.run() == HALT && sim.isHalted());
+
+    RegisterState regs = sim.getRegisters();
+    assert(regs.registers[8] == 5 && regs.registers[9] == 12);
+    assert(regs.registers[10] == 0x12345678);
+    assert(sim.readWord(0x100) == 12);
+    std::vector<uint8_t> bytes = sim.readMemory(0x100, 4);
+    assert(bytes[0] == 0 && bytes[3] == 12);
+    assert(sim.load(DATA, sizeof(DATA)) == ERROR);
+
+    SimulationStats stats = sim.getStats();
+    assert(stats.dynamicInstructions == 6);
+    assert(stats.dcHits + stats.dcMisses == 2);
+
+    // Running a few cycles at a time ends in the same state
+    MipsSim stepped(icConfig, dcConfig);
+    stepped.load(PROGRAM, sizeof(PROGRAM));
+    stepped.load(DATA, sizeof(DATA), 0x200);
+    assert(stepped.run(3) == SUCCESS);
+    assert(stepped.getStats().totalCycles == 3);
+    while (stepped.run(3) != HALT) {
+    }
+    assert(stepped.getStats().totalCycles == stats.totalCycles);
+    RegisterState steppedRegs = stepped.getRegisters();
+    assert(memcmp(&steppedRegs, &regs, sizeof(regs)) == 0);
+
+    // Each core gets its index in $k0, so the cores store to different words
+    SimOptions options;
+    options.cores = 2;
+    MipsSim multi(icConfig, dcConfig, options);
+    multi.load(PROGRAM, sizeof(PROGRAM));
+    assert(multi.run() == HALT);
+    assert(multi.readWord(0x100) == 12 && multi.readWord(0x104) == 12);
+    assert(multi.getRegisters(1).registers[26] == 1);
+
+    // mflo waits in ID until the multiply/divide unit is done
+    SimOptions mulOptions;
+    mulOptions.multLatency = 6;
+    MipsSim mul(icConfig, dcConfig, mulOptions);
+    mul.load(MULT_PROGRAM, sizeof(MULT_PROGRAM));
+    assert(mul.run() == HALT);
+    SimulationStats mulStats = mul.getStats();
+    assert(mulStats.hasMulDivStats && mulStats.mulDivOps == 1);
+    assert(mulStats.mulDivStalls == mulOptions.multLatency - 1);
+    assert(!stats.hasMulDivStats);
+
+    // A simulator that fails to start is dropped, and runs fail until the program is reloaded
+    SimOptions badOptions;
+    badOptions.cores = MAX_CORES + 1;
+    MipsSim bad(icConfig, dcConfig, badOptions);
+    bad.load(PROGRAM, sizeof(PROGRAM));
+    assert(bad.run() == ERROR && !bad.isHalted());
+    assert(bad.run() == ERROR);
+    assert(bad.readWord(0) == 0);
+    assert(bad.load(PROGRAM, sizeof(PROGRAM)) == SUCCESS);
+    assert(bad.run() == ERROR);
+
+    cout << "Cycles: " << stats.totalCycles << endl;
+    cout << "Success..." << endl;
+}
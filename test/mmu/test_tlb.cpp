@@ -0,0 +1,47 @@
+#include "Tlb.h"
+#include "iostream"
+#include <cassert>
+
+using namespace std;
+
+// Tests TLB geometry parsing, page-granular hits and the page walk charged on a miss.
+int main() {
+
+    cout << "Testing TLB!" << endl;
+
+    TlbConfig config;
+    assert(parseTlbConfig("64:4", config) && config.entries == 64 && config.ways == 4);
+    assert(parseTlbConfig("8", config) && config.entries == 8 && config.ways == 8);
+    assert(!parseTlbConfig("48", config));
+    assert(!parseTlbConfig("4:8", config));
+    assert(!parseTlbConfig("0", config));
+    assert(!parseTlbConfig("16:x", config));
+
+    // Fully associative, 2 entries
+    parseTlbConfig("2", config);
+    Tlb tlb(config, 7);
+    const uint32_t walk = MMU_WALK_LEVELS * 7;
+
+    assert(tlb.translate(0x1000) == walk);
+    // Same page, any offset
+    assert(tlb.translate(0x1ffc) == 0);
+    assert(tlb.translate(0x2000) == walk);
+    assert(tlb.translate(0x1004) == 0);
+    // A third page evicts the least recently used one (0x2000)
+    assert(tlb.translate(0x3000) == walk);
+    assert(tlb.translate(0x1000) == 0);
+    assert(tlb.translate(0x2000) == walk);
+    assert(tlb.getHits() == 3 && tlb.getMisses() == 4);
+
+    // Set associative: pages 0 and 2 share a set of a 4 entry, 2 way TLB with 2 sets
+    parseTlbConfig("4:2", config);
+    Tlb sets(config, 1);
+    sets.translate(0x0000);
+    sets.translate(0x2000);
+    sets.translate(0x4000);
+    assert(sets.translate(0x1000) == MMU_WALK_LEVELS);
+    assert(sets.translate(0x0000) == MMU_WALK_LEVELS);
+    assert(sets.translate(0x4000) == 0);
+
+    cout << "Success..." << endl;
+}
@@ -0,0 +1,78 @@
+#include "ExecProfile.h"
+#include "emulator.h"
+#include "iostream"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace std;
+
+static uint32_t iType(uint32_t op, uint32_t rs, uint32_t rt, uint16_t imm) {
+    return (op << 26) | (rs << 21) | (rt << 16) | imm;
+}
+
+// Tests per-PC, branch and basic-block counts of the execution profile.
+int main() {
+
+    cout << "Testing the execution profile!" << endl;
+
+    // A three-iteration loop over 0x4 .. 0xc, the bgtz at 0x8 has its delay slot at 0xc
+    const uint32_t T0 = 8;
+    uint32_t program[] = {
+        iType(OP_ADDIU, 0, T0, 3),               // 0x00
+        iType(OP_ADDI, T0, T0, 0xffff),          // 0x04 loop
+        iType(OP_BGTZ, T0, 0, (uint16_t)-2),     // 0x08
+        0,                                       // 0x0c
+        0xfeedfeed,                              // 0x10
+    };
+    MemoryStore* mem = new MemoryStore(0, MEMORY_SIZE);
+    for (uint32_t i = 0; i < sizeof(program) / sizeof(program[0]); i++)
+        mem->setMemValue(i * 4, program[i], WORD_SIZE);
+
+    Emulator emulator;
+    emulator.setMemory(mem);
+    ExecProfile profile;
+    while (true) {
+        uint32_t pc = emulator.getPC();
+        Emulator::StepResult result = emulator.executeFast();
+        profile.record(pc, result.isBranchTaken);
+        if (result.isHalt) break;
+    }
+
+    assert(profile.getExecutions(0x0) == 1);
+    assert(profile.getExecutions(0x4) == 3);
+    assert(profile.getExecutions(0x8) == 3);
+    assert(profile.getExecutions(0xc) == 3);
+    assert(profile.getExecutions(0x10) == 1);
+    assert(profile.getExecutions(0x100000) == 0);
+    // Taken is charged to the branch itself, not to its delay slot
+    assert(profile.getTaken(0x8) == 2);
+    assert(profile.getTaken(0xc) == 0);
+
+    // PCs near the top of memory are counted without a dense array up to them
+    ExecProfile high;
+    high.record(0xfffffff0, true);
+    high.record(0x10, false);
+    high.record(0x14, false);
+    high.record(0xfffffff0, false);
+    assert(high.getExecutions(0xfffffff0) == 2 && high.getTaken(0xfffffff0) == 1);
+    assert(high.getExecutions(0x14) == 1 && high.getExecutions(0xffffffec) == 0);
+    assert(high.dump("test_profile_high", mem) == SUCCESS);
+    ifstream highReport("test_profile_high_profile.out");
+    string highText((istreambuf_iterator<char>(highReport)), istreambuf_iterator<char>());
+    assert(highText.find("0xfffffff0 0xfffffff0        1            2") != string::npos);
+
+    assert(profile.dump("test_profile", mem) == SUCCESS);
+    ifstream report("test_profile_profile.out");
+    string text((istreambuf_iterator<char>(report)), istreambuf_iterator<char>());
+    cout << text;
+    // The loop body, delay slot included, is the hottest block
+    assert(text.find("0x00000004 0x0000000c        3            3              9") !=
+           string::npos);
+    assert(text.find("bgtz") != string::npos);
+
+    remove("test_profile_profile.out");
+    remove("test_profile_high_profile.out");
+    cout << "Success..." << endl;
+}
@@ -0,0 +1,40 @@
+#include "SpscRing.h"
+#include "iostream"
+#include <cassert>
+#include <thread>
+
+using namespace std;
+
+// Tests the single-producer/single-consumer ring used by the decoupled simulator.
+int main() {
+
+    cout << "Testing SpscRing on one thread!" << endl;
+
+    SpscRing<uint32_t> ring(2);
+    uint32_t value = 0;
+    assert(!ring.pop(value));
+    for (uint32_t i = 0; i < 4; i++) assert(ring.push(i));
+    assert(!ring.push(4));  // full
+    assert(ring.pop(value) && value == 0);
+    assert(ring.push(4));
+    for (uint32_t i = 1; i <= 4; i++) assert(ring.pop(value) && value == i);
+    assert(!ring.pop(value));
+
+    cout << "Testing SpscRing across threads!" << endl;
+
+    const uint32_t count = 1000000;
+    SpscRing<uint32_t> shared(6);
+    thread producer([&]() {
+        for (uint32_t i = 0; i < count; i++) {
+            while (!shared.push(i)) this_thread::yield();
+        }
+    });
+    for (uint32_t i = 0; i < count; i++) {
+        while (!shared.pop(value)) this_thread::yield();
+        assert(value == i);
+    }
+    producer.join();
+    assert(!shared.pop(value));
+
+    cout << "Success..." << endl;
+}
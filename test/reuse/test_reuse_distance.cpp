@@ -0,0 +1,70 @@
+#include "ReuseDistance.h"
+#include "iostream"
+#include <cassert>
+#include <list>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace std;
+
+// Tests the Fenwick-tree reuse distances against an explicit LRU stack.
+int main() {
+
+    cout << "Testing reuse distances!" << endl;
+
+    // Enough accesses to renumber the time slots a couple of times
+    const uint32_t ACCESSES = 150000, INTERVAL = 7000;
+    mt19937 generator(375);
+    uniform_int_distribution<uint32_t> hot(0, 63), all(0, 511);
+    vector<uint32_t> addresses(ACCESSES);
+    for (auto& address : addresses) {
+        address = ((generator() & 3) ? hot(generator) : all(generator)) * 16 + (generator() & 15);
+    }
+
+    ReuseDistance reuse(16);
+    list<uint32_t> stack;  // blocks, most recently used first
+    uint64_t expected[REUSE_BUCKETS] = {};
+    uint64_t expectedCold = 0;
+    vector<uint32_t> expectedSets;
+    set<uint32_t> interval;
+    for (uint32_t i = 0; i < ACCESSES; i++) {
+        uint32_t block = addresses[i] / 16;
+        uint32_t distance = 0;
+        auto it = stack.begin();
+        while (it != stack.end() && *it != block) {
+            ++it;
+            distance++;
+        }
+        if (it == stack.end()) {
+            expectedCold++;
+        } else {
+            expected[distance ? 32 - __builtin_clz(distance) : 0]++;
+            stack.erase(it);
+        }
+        stack.push_front(block);
+        interval.insert(block);
+
+        reuse.access(addresses[i]);
+        if ((i + 1) % INTERVAL == 0) {
+            expectedSets.push_back(interval.size());
+            interval.clear();
+            reuse.endInterval();
+        }
+    }
+
+    assert(reuse.getAccesses() == ACCESSES);
+    assert(reuse.getCold() == expectedCold);
+    for (uint32_t bucket = 0; bucket < REUSE_BUCKETS; bucket++) {
+        assert(reuse.getBucket(bucket) == expected[bucket]);
+    }
+    assert(reuse.getWorkingSets() == expectedSets);
+    assert(reuse.getIntervalBlocks() == interval.size());
+
+    cout << "Cold: " << reuse.getCold() << endl;
+    for (uint32_t bucket = 0; bucket < 11; bucket++) {
+        cout << "Bucket " << bucket << ": " << reuse.getBucket(bucket) << endl;
+    }
+
+    cout << "Success..." << endl;
+}
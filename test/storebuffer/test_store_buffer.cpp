@@ -0,0 +1,66 @@
+#include "StoreBuffer.h"
+#include "iostream"
+#include <cassert>
+
+using namespace std;
+
+// Tests store buffer occupancy, draining and load forwarding.
+int main() {
+
+    cout << "Testing the store buffer!" << endl;
+
+    StoreBuffer buffer(2);
+    uint32_t address;
+
+    // Stores leave right away while there is a free entry
+    assert(buffer.push(0x100, 4, 0) == 0);
+    assert(buffer.push(0x200, 2, 1) == 0);
+
+    // Only the oldest store drains, and its entry frees up once the write completes
+    assert(buffer.nextToDrain(address, 2) && address == 0x100);
+    buffer.startDrain(2, 10);
+    assert(!buffer.nextToDrain(address, 3));
+    buffer.retire(12);
+    assert(buffer.forwards(0x100, 4));
+
+    // Full: the next store waits for the oldest drain to complete at cycle 13 and takes its
+    // entry, so the buffer never holds more than its depth
+    assert(buffer.push(0x300, 1, 5) == 8);
+    assert(buffer.getStats().fullCycles == 8);
+    assert(!buffer.forwards(0x100, 4));
+
+    // The next drain starts once the write port is free again
+    assert(!buffer.nextToDrain(address, 12));
+    assert(buffer.nextToDrain(address, 13) && address == 0x200);
+    buffer.startDrain(13, 0);
+    buffer.retire(14);
+
+    // Loads covered by a buffered store forward, partial overlaps read the cache
+    buffer.push(0x200, 2, 14);
+    assert(buffer.forwards(0x200, 2));
+    assert(buffer.forwards(0x201, 1));
+    assert(!buffer.forwards(0x200, 4));
+    assert(!buffer.forwards(0x400, 4));
+    assert(buffer.forwards(0x300, 1));
+
+    // The youngest overlapping store decides
+    assert(buffer.nextToDrain(address, 15) && address == 0x300);
+    buffer.startDrain(15, 0);
+    buffer.retire(16);
+    buffer.push(0x200, 1, 16);
+    assert(!buffer.forwards(0x200, 2));
+    assert(buffer.forwards(0x200, 1));
+
+    // Everything drains in order
+    for (uint32_t expected : {0x200u, 0x200u}) {
+        assert(buffer.nextToDrain(address, 20) && address == expected);
+        buffer.startDrain(20, 0);
+        buffer.retire(21);
+    }
+    assert(buffer.isEmpty());
+
+    StoreBufferStats stats = buffer.getStats();
+    assert(stats.stores == 5);
+    cout << "Forwarded loads: " << stats.forwards << endl;
+    cout << "Success..." << endl;
+}
@@ -24,6 +24,9 @@ if [[ ! -d "$OBJ_DIR" || -z "$(ls -A "$OBJ_DIR")" ]]; then
     make
 fi
 
+# Always rebuild the library if the simulator changed
+make -s libmipssim
+
 # Create necessary directories
 mkdir -p "$BIN_DIR"
 mkdir -p "$OBJ_DIR"
@@ -40,9 +43,17 @@ find "$SRC_DIR" -type d \( -name "$BIN_DIR" -prune \) -o -type f -name "*.cpp" -
         binary_path="$BIN_DIR/$base_name"
         TEST_BINARIES+=("$binary_path")
 
-        # Compile and link the test file with object files from Makefile
+        # Tests of the whole simulator link against libmipssim.a, the others against the
+        # object files from Makefile
+        if grep -q -e '#include "MipsSim.h"' -e '#include "cycle.h"' -e '#include "Batch.h"' "$file"; then
+            link_files=("../libmipssim.a")
+        else
+            link_files=("$OBJ_DIR"/*.o)
+        fi
+
+        # Compile and link the test file
         echo "Building $binary_path from $file..."
-        g++ "$file" "$OBJ_DIR"/*.o -o "$binary_path" -Wall -Wextra -std=c++17 -I/u/ah7226/COS375-Project-3/src 
+        g++ "$file" "${link_files[@]}" -o "$binary_path" -Wall -Wextra -std=c++17 -pthread -I../src
     fi
 done
 
@@ -0,0 +1,70 @@
+#include "InstrTrace.h"
+#include "iostream"
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+using namespace std;
+
+static uint32_t iType(uint32_t op, uint32_t rs, uint32_t rt, uint16_t imm) {
+    return (op << 26) | (rs << 21) | (rt << 16) | imm;
+}
+
+static void assertSameInfo(const Emulator::InstructionInfo& a, const Emulator::InstructionInfo& b) {
+    assert(a.pc == b.pc && a.nextPC == b.nextPC && a.instruction == b.instruction);
+    assert(a.instructionID == b.instructionID);
+    assert(a.isHalt == b.isHalt && a.isValid == b.isValid && a.isOverflow == b.isOverflow);
+    assert(a.isBranchTaken == b.isBranchTaken);
+    assert(a.opcode == b.opcode && a.rs == b.rs && a.rt == b.rt && a.rd == b.rd);
+    assert(a.shamt == b.shamt && a.funct == b.funct && a.immediate == b.immediate);
+    assert(a.signExtImm == b.signExtImm && a.branchAddr == b.branchAddr);
+    assert(a.jumpAddr == b.jumpAddr);
+    assert(a.loadAddress == b.loadAddress && a.storeAddress == b.storeAddress);
+}
+
+// Records a program with loops, loads, stores and an illegal instruction, then checks the
+// replayed instructions match what the emulator returned.
+int main() {
+
+    cout << "Testing instruction trace record and replay!" << endl;
+
+    const uint32_t T0 = 8, T1 = 9, T2 = 10;
+    uint32_t program[] = {
+        iType(OP_ADDIU, 0, T0, 20),               // 0x00
+        iType(OP_LUI, 0, T1, 0x10),               // 0x04
+        iType(OP_SW, T1, T0, 0),                  // 0x08 loop
+        iType(OP_LBU, T1, T2, 3),                 // 0x0c
+        iType(OP_ADDIU, T1, T1, 0xfff0),          // 0x10
+        iType(OP_ADDIU, T0, T0, 0xffff),          // 0x14
+        iType(OP_BNE, T0, 0, (uint16_t)-5),       // 0x18
+        0,                                        // 0x1c
+        0xfc000000,                               // 0x20 illegal
+    };
+    Emulator emulator;
+    emulator.setMemory(new MemoryStore(0, MEMORY_SIZE));
+    for (uint32_t i = 0; i < sizeof(program) / sizeof(program[0]); i++)
+        emulator.getMemory()->setMemValue(i * 4, program[i], WORD_SIZE);
+    emulator.getMemory()->setMemValue(0x8000, 0xfeedfeed, WORD_SIZE);
+
+    vector<Emulator::InstructionInfo> executed;
+    TraceWriter writer;
+    assert(writer.open("test_instr_trace.trc") == SUCCESS);
+    do {
+        executed.push_back(emulator.executeInstruction());
+        writer.write(executed.back());
+    } while (!executed.back().isHalt);
+    writer.close();
+
+    TraceReader reader;
+    assert(reader.open("test_instr_trace.trc") == SUCCESS);
+    Emulator::InstructionInfo info;
+    for (auto& expected : executed) {
+        assert(reader.next(info));
+        assertSameInfo(expected, info);
+    }
+    assert(!reader.next(info));
+    assert(reader.getCount() == executed.size());
+
+    remove("test_instr_trace.trc");
+    cout << "Success..." << endl;
+}